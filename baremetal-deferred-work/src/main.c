@@ -0,0 +1,91 @@
+/*
+   Baremetal main program with the interrupt work deferred to the MSI handler.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   The timer (MTI) handler only re-programs the timer and posts a work
+   item. The work item runs with interrupts enabled from the software
+   interrupt (MSI) handler, or from the idle loop when built with
+   DEFERRED_RUN_FROM_IDLE.
+
+*/
+
+#include <stdint.h>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+#include "timer.h"
+
+#include "vector_table.h"
+#include "deferred.h"
+
+#define RISCV_MTVEC_MODE_VECTORED 1
+
+// Work done per timer tick
+#define WORK_ITERATIONS 200
+
+// Counters and results, traced by test/run_sim.cmd
+static volatile uint32_t mti_count = 0;
+static volatile uint32_t work_count = 0;
+static volatile uint64_t timestamp = 0;
+static volatile uint32_t work_result = 0;
+
+// Deferred part of the timer interrupt, runs with interrupts enabled.
+static void timer_work(uintptr_t arg) {
+    uint32_t result = (uint32_t)arg;
+    for (unsigned int i = 0; i < WORK_ITERATIONS; i++) {
+        result = (result * 1103515245UL) + 12345UL;
+    }
+    work_result = result;
+    work_count++;
+}
+
+int main(void) {
+    // Global interrupt disable
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    csr_write_mie(0);
+
+    // Setup the IRQ handler entry point, set the mode to vectored
+    csr_write_mtvec((uint_xlen_t) riscv_mtvec_table | RISCV_MTVEC_MODE_VECTORED);
+
+    // Enable MIE.MTI and MIE.MSI
+    csr_set_bits_mie(MIE_MTI_BIT_MASK | MIE_MSI_BIT_MASK);
+
+    // Global interrupt enable
+    csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    // Setup timer for 100 usec interval
+    mtimer_set_raw_time_cmp(MTIMER_USEC_TO_CLOCKS(100));
+
+    // Busy loop
+    do {
+#if defined(DEFERRED_RUN_FROM_IDLE)
+        // Run the work, then wait for timer interrupt
+        deferred_idle();
+#else
+        // Wait for timer interrupt
+        __asm__ volatile ("wfi");
+#endif
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+// The 'riscv_mtvec_mti' function is added to the vector table by the vector_table.c
+void riscv_mtvec_mti(void)  {
+    mtimer_set_raw_time_cmp(MTIMER_USEC_TO_CLOCKS(100));
+    timestamp = mtimer_get_raw_time();
+    mti_count++;
+    deferred_post(timer_work, (uintptr_t)timestamp);
+}
+// The 'riscv_mtvec_msi' function is added to the vector table by the vector_table.c
+void riscv_mtvec_msi(void)  {
+    deferred_run_msi();
+}
+#pragma GCC pop_options
@@ -0,0 +1,14 @@
+until pc 0 main
+pc 0
+
+run 50000
+mem mti_count
+mem work_count
+mem deferred_queue
+
+run 50000
+mem mti_count
+mem work_count
+mem deferred_queue
+
+q
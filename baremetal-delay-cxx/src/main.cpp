@@ -0,0 +1,108 @@
+/*
+   Baremetal accuracy test of the calibrated busy-wait delays.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   Calibrate the core clock against the system timer, then measure
+   a set of delay_ns(), delay_us() and delay() calls with mcycle and mtime.
+
+*/
+
+#include <cstdint>
+#include <chrono>
+
+#include "riscv-csr.hpp"
+#include "timer.hpp"
+#include "delay.hpp"
+
+// From riscv-isa-sim/riscv/sim.h, the HiFive board uses driver::default_timer_config
+struct sim_timer_config {
+    static constexpr unsigned int MTIME_FREQ_HZ=10000000;
+};
+
+using timer_config = sim_timer_config;
+using test_timer = driver::timer<std::chrono::microseconds, driver::mtimer_address_spec, timer_config>;
+
+// The simulator updates mtime in coarse steps, so calibrate over a longer period.
+static constexpr std::uint32_t CALIBRATION_TICKS = 10000;
+
+// Delay function under test
+enum class delay_fn : std::uint32_t {
+    ns,      // riscv::delay_ns()
+    us,      // riscv::delay_us()
+    chrono,  // riscv::delay() with std::chrono::microseconds
+};
+struct delay_test {
+    delay_fn fn;
+    // Requested delay, in nano-seconds
+    std::uint32_t ns;
+};
+
+// Delays to measure
+static constexpr delay_test test_delays[] = {
+    { delay_fn::ns,     100 },
+    { delay_fn::ns,     500 },
+    { delay_fn::ns,     1000 },
+    { delay_fn::ns,     10000 },
+    { delay_fn::ns,     100000 },
+    { delay_fn::ns,     1000000 },
+    { delay_fn::us,     1000 },
+    { delay_fn::us,     10000 },
+    { delay_fn::us,     1000000 },
+    { delay_fn::chrono, 1000 },
+    { delay_fn::chrono, 10000 },
+    { delay_fn::chrono, 1000000 },
+};
+
+// Results of each test, written in order. Traced by test/run_sim.cmd
+static volatile std::uint64_t core_freq_hz{0};
+// Delay function and requested delay
+static volatile std::uint32_t result_fn{0};
+static volatile std::uint32_t result_ns{0};
+// Expected cycles from the calibrated core frequency
+static volatile std::uint32_t result_expected_cycles{0};
+// Measured with mcycle
+static volatile std::uint32_t result_measured_cycles{0};
+// Measured with mtime
+static volatile std::uint32_t result_measured_ticks{0};
+// Count of completed test runs
+static volatile std::uint32_t test_count{0};
+
+int main(void) {
+    // Global interrupt disable, measure without interruption
+    riscv::csrs.mstatus.mie.clr();
+
+    riscv::delay_calibrate<timer_config, test_timer, CALIBRATION_TICKS>();
+    core_freq_hz = riscv::delay_calibration::core_freq_hz;
+
+    test_timer timer;
+    do {
+        for (const auto &test : test_delays) {
+            auto start_tick = timer.get_raw_time();
+            riscv::csr::uint_xlen_t start_cycle = riscv::csrs.mcycle.read();
+            switch (test.fn) {
+            case delay_fn::ns:
+                riscv::delay_ns(test.ns);
+                break;
+            case delay_fn::us:
+                riscv::delay_us(test.ns / 1000);
+                break;
+            case delay_fn::chrono:
+                riscv::delay(std::chrono::microseconds{test.ns / 1000});
+                break;
+            }
+            riscv::csr::uint_xlen_t end_cycle = riscv::csrs.mcycle.read();
+            auto end_tick = timer.get_raw_time();
+            result_fn = static_cast<std::uint32_t>(test.fn);
+            result_ns = test.ns;
+            result_expected_cycles = (core_freq_hz * test.ns) / 1000000000ULL;
+            result_measured_cycles = end_cycle - start_cycle;
+            result_measured_ticks = end_tick - start_tick;
+        }
+        test_count++;
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
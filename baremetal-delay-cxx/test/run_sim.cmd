@@ -0,0 +1,16 @@
+echo on
+
+trace _ZL9result_fn
+trace _ZL9result_ns
+trace _ZL22result_expected_cycles
+trace _ZL22result_measured_cycles
+trace _ZL21result_measured_ticks
+
+until pc 0 main
+pc 0
+
+run 3000000
+mem _ZL12core_freq_hz
+mem _ZL10test_count
+
+q
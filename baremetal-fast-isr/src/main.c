@@ -0,0 +1,105 @@
+/*
+   Baremetal benchmark of a fast interrupt handler.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   Measures the cost of a machine software interrupt (MSI) handled by
+   an interrupt ("machine") function, or by a naked fast handler stub
+   when built with VECTOR_TABLE_MTVEC_FAST_MSI.
+
+*/
+
+#include <stdint.h>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+#include "timer.h"
+
+#include "vector_table.h"
+
+// Number of interrupts per measurement
+#define BENCH_ITERATIONS 64
+
+#define RISCV_MTVEC_MODE_VECTORED 1
+
+#define STRINGIFY(X) #X
+#define TO_STRING(X) STRINGIFY(X)
+
+// Count each interrupt. Not static, it is referenced by the fast handler assembly.
+volatile uint32_t msi_count = 0;
+
+// Results in cycles, for BENCH_ITERATIONS interrupts. Traced by test/run_sim.cmd
+// Raise and clear MSI with interrupts disabled, subtract from msi_cycles
+static volatile uint_xlen_t loop_cycles = 0;
+// Raise MSI, cleared by the interrupt handler
+static volatile uint_xlen_t msi_cycles = 0;
+// Count of completed measurement runs
+static volatile uint32_t bench_count = 0;
+
+int main(void) {
+    // Global interrupt disable
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    csr_write_mie(0);
+
+    // Setup the IRQ handler entry point, set the mode to vectored
+    csr_write_mtvec((uint_xlen_t) riscv_mtvec_table | RISCV_MTVEC_MODE_VECTORED);
+    // mscratch points to the save area of the fast handlers
+    riscv_mtvec_fast_init();
+
+    // Enable MIE.MSI
+    csr_set_bits_mie(MIE_MSI_BIT_MASK);
+
+    do {
+        uint_xlen_t start_cycle;
+
+        // Baseline, the interrupt is not taken
+        csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+        start_cycle = csr_read_mcycle();
+        for (unsigned int i = 0; i < BENCH_ITERATIONS; i++) {
+            clint_set_msip(0);
+            clint_clr_msip(0);
+        }
+        loop_cycles = csr_read_mcycle() - start_cycle;
+
+        // Interrupt taken immediately, the handler clears msip
+        csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+        start_cycle = csr_read_mcycle();
+        for (unsigned int i = 0; i < BENCH_ITERATIONS; i++) {
+            clint_set_msip(0);
+        }
+        msi_cycles = csr_read_mcycle() - start_cycle;
+
+        bench_count++;
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
+
+#if defined(VECTOR_TABLE_MTVEC_FAST_MSI)
+
+// Fast handler, added to the vector table by vector_table.c. Uses 2 registers, t0 and t1.
+VECTOR_TABLE_FAST_HANDLER(riscv_mtvec_msi_fast, 2,
+    "li   t0, " TO_STRING(RISCV_MSIP_ADDR) ";"
+    "sw   zero, 0(t0);"
+    "la   t0, msi_count;"
+    "lw   t1, 0(t0);"
+    "addi t1, t1, 1;"
+    "sw   t1, 0(t0);"
+    )
+
+#else
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+// The 'riscv_mtvec_msi' function is added to the vector table by the vector_table.c
+void riscv_mtvec_msi(void) {
+    clint_clr_msip(0);
+    msi_count++;
+}
+#pragma GCC pop_options
+
+#endif
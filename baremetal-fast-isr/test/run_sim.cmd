@@ -0,0 +1,18 @@
+echo on
+
+until pc 0 main
+pc 0
+
+run 10000
+mem bench_count
+mem msi_count
+mem loop_cycles
+mem msi_cycles
+
+run 10000
+mem bench_count
+mem msi_count
+mem loop_cycles
+mem msi_cycles
+
+q
@@ -0,0 +1,125 @@
+/*
+   Baremetal main program with lazy floating point context save.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   Built for rv32imafc. The main loop keeps a float counter in an FP
+   register. The timer interrupt handler does not use FP and runs with
+   mstatus.FS Off. The software interrupt (MSI) handler uses FP, the
+   caller saved FP registers are saved only because the main loop left
+   FS Dirty.
+
+*/
+
+#include <cstdint>
+#include <chrono>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.hpp"
+#include "riscv-interrupts.hpp"
+#include "timer.hpp"
+#include "vector_table.hpp"
+#include "fpu_context.hpp"
+
+#if !defined(__riscv_flen)
+#error "Build with the F extension, e.g. -march=rv32imafc_zicsr"
+#endif
+
+// From riscv-isa-sim/riscv/sim.h, the HiFive board uses driver::default_timer_config
+struct sim_timer_config {
+    static constexpr unsigned int MTIME_FREQ_HZ=10000000;
+};
+
+// Timer driver
+static driver::timer<std::chrono::microseconds, driver::mtimer_address_spec, sim_timer_config> mtimer;
+
+// Timer interrupt period
+static constexpr std::chrono::microseconds TICK_PERIOD{100};
+// Main loop iterations between software interrupts
+static constexpr std::uint32_t MSI_INTERVAL = 256;
+
+// Handlers, plain functions called by riscv::fpu_context entries
+static void mti_handler(void);
+static void msi_handler(void);
+static void default_handler(void) __attribute__ ((interrupt ("machine")));
+
+using trap_table = riscv::mtvec_table<default_handler,
+                                      riscv::vector<riscv::interrupts::mti, riscv::fpu_context::entry<mti_handler>>,
+                                      riscv::vector<riscv::interrupts::msi, riscv::fpu_context::entry_fp<msi_handler>>>;
+
+// Results, traced by test/run_sim.cmd
+static volatile std::uint32_t mti_count{0};
+static volatile std::uint32_t msi_count{0};
+static volatile std::uint32_t default_count{0};
+// mstatus.FS seen by the handlers, Off in mti_handler
+static volatile std::uint32_t mti_fs{0xFF};
+static volatile std::uint32_t msi_fs{0xFF};
+// Times the float counter of the main loop did not match the integer counter, expected 0
+static volatile std::uint32_t fp_mismatch{0};
+// Running average computed with FP in msi_handler
+static volatile float msi_average{0.0f};
+
+int main(void) {
+    // Global interrupt disable
+    riscv::csrs.mstatus.mie.clr();
+    riscv::csrs.mie.write(0);
+
+    // FS is Off after reset
+    riscv::fpu_context::init();
+
+    // Setup the IRQ handler entry point, set the mode to vectored
+    riscv::csrs.mtvec.write(trap_table::mtvec());
+
+    mtimer.set_time_cmp(TICK_PERIOD);
+
+    // Timer and software interrupt enable
+    riscv::csrs.mie.mti.set();
+    riscv::csrs.mie.msi.set();
+    // Global interrupt enable
+    riscv::csrs.mstatus.mie.set();
+
+    // A float counter held in an FP register, FS is Dirty from here on.
+    float count_f = 0.0f;
+    std::uint32_t count = 0;
+    do {
+        count_f += 1.0f;
+        count++;
+        if ((count % MSI_INTERVAL) == 0) {
+            mtimer.set_msip();
+        }
+        if (count_f != static_cast<float>(count)) {
+            fp_mismatch = fp_mismatch + 1;
+        }
+        // Exact while below 2^24
+        if (count == (1UL << 24)) {
+            count_f = 0.0f;
+            count = 0;
+        }
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
+
+static void mti_handler(void) {
+    mti_count++;
+    mti_fs = riscv::fpu_context::state();
+    mtimer.set_time_cmp(TICK_PERIOD);
+}
+
+static void msi_handler(void) {
+    mtimer.clr_msip();
+    msi_count++;
+    // Clobbers caller saved FP registers, restored by the entry
+    msi_average = msi_average + (static_cast<float>(msi_count) - msi_average) * 0.125f;
+    msi_fs = riscv::fpu_context::state();
+}
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+static void default_handler(void) {
+    default_count++;
+}
+#pragma GCC pop_options
@@ -0,0 +1,20 @@
+echo on
+
+until pc 0 main
+pc 0
+
+run 200000
+mem _ZL9mti_count
+mem _ZL9msi_count
+mem _ZL6mti_fs
+mem _ZL6msi_fs
+mem _ZL11fp_mismatch
+mem _ZL11msi_average
+mem _ZL13default_count
+
+run 200000
+mem _ZL9mti_count
+mem _ZL9msi_count
+mem _ZL11fp_mismatch
+
+q
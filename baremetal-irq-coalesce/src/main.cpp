@@ -0,0 +1,137 @@
+/*
+   Baremetal main program with interrupt coalescing and adaptive polling.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   A simulated receive device raises an interrupt while packets are
+   waiting. riscv::irq_coalesce handles a burst of packets per interrupt,
+   and switches the device to polling from the timer interrupt when the
+   packet rate is high.
+
+   The ISA simulator can raise the machine software interrupt (MSI)
+   from the program, so the simulated device uses MSI. A real device
+   would use the default source, riscv::csr::mie_data::mei.
+
+*/
+
+#include <cstdint>
+#include <chrono>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.hpp"
+#include "riscv-interrupts.hpp"
+#include "timer.hpp"
+#include "vector_table.hpp"
+#include "irq_coalesce.hpp"
+
+// From riscv-isa-sim/riscv/sim.h, the HiFive board uses driver::default_timer_config
+struct sim_timer_config {
+    static constexpr unsigned int MTIME_FREQ_HZ=10000000;
+};
+
+// Timer driver
+static driver::timer<std::chrono::microseconds, driver::mtimer_address_spec, sim_timer_config> mtimer;
+
+// Poll period in polled mode, and the rate measurement window in interrupt mode
+static constexpr std::chrono::microseconds TICK_PERIOD{100};
+// Timer ticks in each phase of low then high packet rate
+static constexpr std::uint32_t PHASE_TICKS = 20;
+// Busy loop iterations between packets at the low and high rate
+static constexpr std::uint32_t LOW_RATE_DELAY = 500;
+static constexpr std::uint32_t HIGH_RATE_DELAY = 5;
+
+// Simulated receive device, main() is the producer and the interrupt handler the consumer.
+static volatile std::uint32_t rx_produced{0};
+static volatile std::uint32_t rx_consumed{0};
+
+// Service one packet of the simulated device, return false if none is waiting.
+static bool rx_packet(void);
+
+struct rx_coalesce_config : riscv::default_coalesce_config {
+    static constexpr std::uint32_t BUDGET_EVENTS = 8;
+};
+using rx_coalesce = riscv::irq_coalesce<rx_packet, riscv::csr::mie_data::msi, rx_coalesce_config>;
+
+// Machine mode trap handlers
+static void mti_handler(void) __attribute__ ((interrupt ("machine")));
+static void rx_handler(void) __attribute__ ((interrupt ("machine")));
+static void default_handler(void) __attribute__ ((interrupt ("machine")));
+
+using trap_table = riscv::mtvec_table<default_handler,
+                                      riscv::vector<riscv::interrupts::mti, mti_handler>,
+                                      riscv::vector<riscv::interrupts::msi, rx_handler>>;
+
+// Results, traced by test/run_sim.cmd
+static volatile std::uint32_t mti_count{0};
+static volatile std::uint32_t default_count{0};
+static volatile std::uint32_t high_rate{0};
+static volatile std::uint32_t irq_count{0};
+static volatile std::uint32_t poll_count{0};
+static volatile std::uint32_t poll_enter_count{0};
+
+int main(void) {
+    // Global interrupt disable
+    riscv::csrs.mstatus.mie.clr();
+    riscv::csrs.mie.write(0);
+
+    // Setup the IRQ handler entry point, set the mode to vectored
+    riscv::csrs.mtvec.write(trap_table::mtvec());
+
+    mtimer.set_time_cmp(TICK_PERIOD);
+
+    // Timer and device interrupt enable
+    riscv::csrs.mie.mti.set();
+    riscv::csrs.mie.msi.set();
+    // Global interrupt enable
+    riscv::csrs.mstatus.mie.set();
+
+    // Generate packets, alternating between a low and a high rate
+    do {
+        high_rate = (mti_count / PHASE_TICKS) & 1;
+        std::uint32_t delay = high_rate ? HIGH_RATE_DELAY : LOW_RATE_DELAY;
+        for (volatile std::uint32_t i = 0; i < delay; i++) {
+        }
+        rx_produced = rx_produced + 1;
+        // Device interrupt while packets are waiting
+        mtimer.set_msip();
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
+
+static bool rx_packet(void) {
+    if (rx_consumed == rx_produced) {
+        return false;
+    }
+    rx_consumed = rx_consumed + 1;
+    if (rx_consumed == rx_produced) {
+        // Empty, clear the interrupt. Check again for a packet produced before msip was cleared.
+        mtimer.clr_msip();
+        if (rx_consumed != rx_produced) {
+            mtimer.set_msip();
+        }
+    }
+    return true;
+}
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+static void mti_handler(void) {
+    mti_count++;
+    mtimer.set_time_cmp(TICK_PERIOD);
+    // Poll the device, or check the interrupt rate
+    rx_coalesce::tick();
+    irq_count = rx_coalesce::irq_count;
+    poll_count = rx_coalesce::poll_count;
+    poll_enter_count = rx_coalesce::poll_enter_count;
+}
+static void rx_handler(void) {
+    rx_coalesce::irq();
+}
+static void default_handler(void) {
+    default_count++;
+}
+#pragma GCC pop_options
@@ -0,0 +1,24 @@
+echo on
+
+until pc 0 main
+pc 0
+
+run 200000
+mem _ZL9mti_count
+mem _ZL9high_rate
+mem _ZL11rx_produced
+mem _ZL11rx_consumed
+mem _ZL9irq_count
+mem _ZL10poll_count
+mem _ZL16poll_enter_count
+
+run 200000
+mem _ZL9mti_count
+mem _ZL9high_rate
+mem _ZL11rx_produced
+mem _ZL11rx_consumed
+mem _ZL9irq_count
+mem _ZL10poll_count
+mem _ZL16poll_enter_count
+
+q
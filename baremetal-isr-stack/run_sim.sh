@@ -0,0 +1,18 @@
+#!/bin/bash
+
+SPIKE=../../riscv-isa-sim/spike
+CMD_FILE=./test/run_sim.cmd
+MARCH=rv32imac_zicsr
+MMAP=0x8000000:0x2000,0x80000000:0x4000,0x20010000:0x6a120
+CYCLES=200000
+
+${SPIKE} \
+    --priv=m \
+    --isa=${MARCH} \
+    -l \
+    -m${MMAP} \
+    --max-cycles ${CYCLES} \
+    --log test/run_sim.log \
+    -d \
+    --debug-cmd=${CMD_FILE} \
+    build/main.elf 2> test/trace.log
@@ -0,0 +1,83 @@
+/*
+   Baremetal main program with the interrupt handlers on a dedicated stack.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   The timer (MTI) and software (MSI) interrupt handlers run on the
+   interrupt stack allocated by linker.lds. MTI may preempt MSI, the
+   nested handler stays on the interrupt stack. The maximum usage of
+   the main and interrupt stacks is reported in stack_usage_main and
+   stack_usage_isr.
+
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+#include "timer.h"
+
+#include "vector_table.h"
+#include "isr_stack.h"
+
+#define RISCV_MTVEC_MODE_VECTORED 1
+
+// Interrupt counters, traced by test/run_sim.cmd
+static volatile uint32_t mti_count = 0;
+static volatile uint32_t msi_count = 0;
+// Bytes used on each stack, updated by the main loop
+static volatile size_t stack_usage_main = 0;
+static volatile size_t stack_usage_isr = 0;
+
+int main(void) {
+    // Global interrupt disable
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    csr_write_mie(0);
+
+    // Paint the stacks and point mscratch to the interrupt stack
+    isr_stack_init();
+
+    // Setup the IRQ handler entry point, set the mode to vectored
+    csr_write_mtvec((uint_xlen_t) riscv_mtvec_table | RISCV_MTVEC_MODE_VECTORED);
+
+    // Enable MIE.MTI and MIE.MSI
+    csr_set_bits_mie(MIE_MTI_BIT_MASK | MIE_MSI_BIT_MASK);
+
+    // Global interrupt enable
+    csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    // Setup timer for 1 msec interval
+    mtimer_set_raw_time_cmp(MTIMER_MSEC_TO_CLOCKS(1));
+
+    // Busy loop
+    do {
+        // Raise a software interrupt, cleared by the handler
+        clint_set_msip(0);
+        stack_usage_main = isr_stack_usage_main();
+        stack_usage_isr = isr_stack_usage_isr();
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+// The 'riscv_mtvec_mti' function is called via the interrupt stack entry in vector_table.c
+void riscv_mtvec_mti(void)  {
+    mtimer_set_raw_time_cmp(MTIMER_MSEC_TO_CLOCKS(1));
+    mti_count++;
+}
+// The 'riscv_mtvec_msi' function is called via the interrupt stack entry in vector_table.c
+// Spend some time in the handler so that MTI preempts it.
+void riscv_mtvec_msi(void)  {
+    clint_clr_msip(0);
+    for (volatile int i = 0; i < 100; i++) {
+    }
+    msi_count++;
+}
+#pragma GCC pop_options
@@ -0,0 +1,16 @@
+until pc 0 main
+pc 0
+
+run 50000
+mem mti_count
+mem msi_count
+mem stack_usage_main
+mem stack_usage_isr
+
+run 50000
+mem mti_count
+mem msi_count
+mem stack_usage_main
+mem stack_usage_isr
+
+q
@@ -0,0 +1,11 @@
+#!/bin/bash
+
+# QEMU sifive_e machine, revb=true selects the HiFive1 revb memory map of linker.lds
+QEMU=qemu-system-riscv32
+ELF_FILE=build/main.elf
+
+# Exit with Ctrl-A x
+${QEMU} \
+    -machine sifive_e,revb=true \
+    -nographic \
+    -kernel ${ELF_FILE}
@@ -0,0 +1,151 @@
+/*
+   Baremetal main program with PLIC external interrupts.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   Runs on the SiFive HiFive1 revb, or the QEMU sifive_e machine. The
+   UART0 transmit and receive watermark interrupts are routed through
+   the PLIC to the machine external interrupt (MEI). The MEI handler
+   claims and dispatches every pending PLIC source before returning.
+
+*/
+
+#include <cstdint>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.hpp"
+#include "riscv-interrupts.hpp"
+#include "vector_table.hpp"
+#include "plic.hpp"
+
+// FE310 UART0, from freedom-e-sdk/bsp/sifive-hifive1-revb/design.svd
+struct uart0 {
+    static constexpr std::uintptr_t BASE_ADDR = 0x10013000;
+    static constexpr std::uint32_t PLIC_SOURCE = 3;
+
+    static volatile std::uint32_t &reg(std::uintptr_t offset) {
+        return *reinterpret_cast<volatile std::uint32_t *>(BASE_ADDR + offset);
+    }
+    static volatile std::uint32_t &txdata(void) { return reg(0x00); }
+    static volatile std::uint32_t &rxdata(void) { return reg(0x04); }
+    static volatile std::uint32_t &txctrl(void) { return reg(0x08); }
+    static volatile std::uint32_t &rxctrl(void) { return reg(0x0C); }
+    static volatile std::uint32_t &ie(void)     { return reg(0x10); }
+
+    static constexpr std::uint32_t TXDATA_FULL  = 0x80000000;
+    static constexpr std::uint32_t RXDATA_EMPTY = 0x80000000;
+    static constexpr std::uint32_t CTRL_EN      = 0x1;
+    static constexpr std::uint32_t CTRL_CNT_1   = (1 << 16);
+    static constexpr std::uint32_t IE_TXWM      = 0x1;
+    static constexpr std::uint32_t IE_RXWM      = 0x2;
+};
+
+using plic = driver::plic<>;
+
+// PLIC source handlers
+static void uart0_handler(void);
+static void unhandled_source(void);
+
+// PLIC sources dispatched by the MEI handler, generated at compile time.
+using plic_table = plic::table<unhandled_source,
+                               driver::plic_vector<uart0::PLIC_SOURCE, uart0_handler>>;
+
+// Machine mode trap handlers
+static void mei_handler(void) __attribute__ ((interrupt ("machine")));
+static void default_handler(void) __attribute__ ((interrupt ("machine")));
+
+using trap_table = riscv::mtvec_table<default_handler,
+                                      riscv::vector<riscv::interrupts::mei, mei_handler>>;
+
+static const char message[] = "PLIC UART0 interrupt example, type to echo.\r\n";
+
+// Next character of message to transmit
+static volatile std::uint32_t message_index{0};
+// Received character to echo, or RXDATA_EMPTY
+static volatile std::uint32_t echo_char{uart0::RXDATA_EMPTY};
+
+// MEI trap entries
+static volatile std::uint32_t mei_count{0};
+// PLIC sources claimed
+static volatile std::uint32_t claim_count{0};
+// Most sources claimed by one trap
+static volatile std::uint32_t claim_max{0};
+// Claimed sources with no handler
+static volatile std::uint32_t unhandled_count{0};
+// Unexpected traps
+static volatile std::uint32_t default_count{0};
+
+int main(void) {
+    // Global interrupt disable
+    riscv::csrs.mstatus.mie.clr();
+    riscv::csrs.mie.write(0);
+
+    // Setup the IRQ handler entry point, set the mode to vectored
+    riscv::csrs.mtvec.write(trap_table::mtvec());
+
+    // UART0, interrupt when the transmit FIFO is empty and when a character is received
+    uart0::txctrl() = uart0::CTRL_EN | uart0::CTRL_CNT_1;
+    uart0::rxctrl() = uart0::CTRL_EN;
+    uart0::ie() = uart0::IE_TXWM | uart0::IE_RXWM;
+
+    // Route UART0 to this hart
+    plic::set_priority(uart0::PLIC_SOURCE, 1);
+    plic::enable(uart0::PLIC_SOURCE);
+    plic::set_threshold(0);
+
+    // External interrupt enable
+    riscv::csrs.mie.mei.set();
+    // Global interrupt enable
+    riscv::csrs.mstatus.mie.set();
+
+    // Busy loop
+    do {
+        __asm__ volatile ("wfi");
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+static void mei_handler(void) {
+    mei_count++;
+    auto count = plic::handle<plic_table>();
+    claim_count += count;
+    if (count > claim_max) {
+        claim_max = count;
+    }
+}
+static void default_handler(void) {
+    default_count++;
+}
+#pragma GCC pop_options
+
+// Transmit the message, then echo received characters.
+static void uart0_handler(void) {
+    std::uint32_t rx = uart0::rxdata();
+    if ((rx & uart0::RXDATA_EMPTY) == 0) {
+        echo_char = rx & 0xFF;
+        uart0::ie() = uart0::ie() | uart0::IE_TXWM;
+    }
+    if ((uart0::txdata() & uart0::TXDATA_FULL) != 0) {
+        return;
+    }
+    if (message_index < (sizeof(message) - 1)) {
+        uart0::txdata() = static_cast<std::uint8_t>(message[message_index]);
+        message_index++;
+    } else if ((echo_char & uart0::RXDATA_EMPTY) == 0) {
+        uart0::txdata() = echo_char;
+        echo_char = uart0::RXDATA_EMPTY;
+    } else {
+        // Nothing to send
+        uart0::ie() = uart0::ie() & ~uart0::IE_TXWM;
+    }
+}
+
+static void unhandled_source(void) {
+    unhandled_count++;
+}
@@ -0,0 +1,83 @@
+/*
+   Baremetal main program with a compile time planned PMP configuration.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   The MEMORY regions of linker.lds and the CLINT are converted to PMP
+   entries by riscv::pmp::make_plan() at compile time. The entries are
+   locked so they also apply to M-mode: rom is read and execute only, ram
+   is read and write only. A store to a constant in rom is a store access
+   fault, the handler records the address and skips the store.
+
+*/
+
+#include <cstdint>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.hpp"
+#include "riscv-interrupts.hpp"
+#include "trap_dispatch.hpp"
+#include "pmp.hpp"
+
+// From MEMORY in linker.lds, and the CLINT of the simulator (msip, mtimecmp, mtime)
+static constexpr riscv::pmp::region memory_map[] = {
+    {0x08000000, 0x2000,  riscv::pmp::R | riscv::pmp::W | riscv::pmp::X | riscv::pmp::L}, // itim
+    {0x80000000, 0x4000,  riscv::pmp::R | riscv::pmp::W | riscv::pmp::L},                 // ram
+    {0x20010000, 0x6a120, riscv::pmp::R | riscv::pmp::X | riscv::pmp::L},                 // rom
+    {0x02000000, 0x10000, riscv::pmp::R | riscv::pmp::W | riscv::pmp::L},                 // clint
+};
+static constexpr riscv::pmp::plan_t pmp_plan = riscv::pmp::make_plan(memory_map);
+// itim, ram and clint are NAPOT, the size of rom is not a power of 2, it is a TOR pair.
+static_assert(pmp_plan.count == 5, "Unexpected number of PMP entries");
+
+// Handlers, plain functions called by riscv::trap_dispatch
+static void store_fault_handler(void);
+static void nop_handler(void) {}
+
+using interrupts = riscv::dispatch_table<16, nop_handler>;
+using exceptions = riscv::dispatch_table<16, nop_handler,
+                                         riscv::dispatch_vector<riscv::exceptions::store_amo_access_fault, store_fault_handler>>;
+using trap = riscv::trap_dispatch<interrupts, exceptions>;
+
+// In .rodata, placed in rom
+static const std::uint32_t rom_constant = 0x12345678;
+
+// Results, traced by test/run_sim.cmd
+static volatile std::uint32_t store_fault_count{0};
+static volatile std::uintptr_t store_fault_address{0};
+// rom_constant read back after the store, unchanged
+static volatile std::uint32_t rom_value{0};
+
+int main(void) {
+    // Global interrupt disable
+    riscv::csrs.mstatus.mie.clr();
+    riscv::csrs.mie.write(0);
+
+    // Setup the trap handler entry point, direct mode
+    riscv::csrs.mtvec.write(reinterpret_cast<std::uintptr_t>(trap::entry));
+
+    // Straight line csrw of the planned values
+    riscv::pmp::program<pmp_plan>::write();
+
+    // Try to write a constant in rom
+    *const_cast<volatile std::uint32_t *>(&rom_constant) = 0;
+    rom_value = *const_cast<volatile const std::uint32_t *>(&rom_constant);
+
+    // Busy loop
+    do {
+        __asm__ volatile ("wfi");
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
+
+static void store_fault_handler(void) {
+    store_fault_count = store_fault_count + 1;
+    store_fault_address = riscv::csrs.mtval.read();
+    // Skip the store, 2 or 4 bytes
+    auto this_pc = riscv::csrs.mepc.read();
+    auto opcode = *reinterpret_cast<const volatile std::uint16_t *>(this_pc);
+    riscv::csrs.mepc.write(this_pc + (((opcode & 0x3) == 0x3) ? 4 : 2));
+}
@@ -0,0 +1,11 @@
+echo on
+
+until pc 0 main
+pc 0
+
+run 10000
+mem _ZL17store_fault_count
+mem _ZL19store_fault_address
+mem _ZL9rom_value
+
+q
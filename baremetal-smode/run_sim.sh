@@ -0,0 +1,29 @@
+#!/bin/bash
+
+SPIKE=../../riscv-isa-sim/spike
+MARCH=rv32imac_zicsr_zicntr_sstc
+MMAP=0x8000000:0x2000,0x80000000:0x4000,0x20010000:0x6a120
+# The core runs in 5000 cycle increments, then updates the system (see sim.h:INTERLEAVE)
+# This will run for 20 such super cycles
+CYCLES=100000
+
+# Run the delegated version, then the M-mode forwarding version
+for ELF in main main_forward ; do
+    echo "--- ${ELF} ---"
+    # sti_forward_latency is only in main_forward.elf
+    CMD_FILE=./test/run_sim.cmd
+    if [ ${ELF} == main_forward ] ; then
+        CMD_FILE=./test/run_sim_forward.cmd
+    fi
+    ${SPIKE} \
+        --vcd-log=test/vcd-trace_${ELF}.vcd \
+        --priv=msu \
+        --isa=${MARCH} \
+        -l \
+        -m${MMAP} \
+        --max-cycles ${CYCLES} \
+        --log test/run_sim_${ELF}.log \
+        -d \
+        --debug-cmd=${CMD_FILE} \
+        build/${ELF}.elf 2> test/trace_${ELF}.log
+done
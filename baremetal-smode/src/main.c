@@ -0,0 +1,224 @@
+/*
+   Baremetal main program with supervisor mode timer and software interrupts.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   Requires a core with S-mode, and the Sstc extension unless SMODE_FORWARD is defined.
+   Tested with the RISC-V ISA simulator.
+
+*/
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+#include "timer.h"
+#include "smode.h"
+
+#include "vector_table.h"
+
+#define RISCV_MTVEC_MODE_VECTORED 1
+
+// Timer period for the supervisor timer interrupt
+#define TIMER_PERIOD MTIMER_MSEC_TO_CLOCKS(1)
+
+/* Interrupt latency, each source has its own unit:
+   - ssi_latency: cycle clocks from raising SSI to the S-mode handler entry.
+   - sti_latency: time clocks from the timer compare value to the S-mode handler entry.
+   - sti_forward_latency: cycle clocks from the M-mode MTI handler entry to the S-mode STI handler entry (SMODE_FORWARD only).
+*/
+struct latency_stats {
+    // First, for "mem" in run_sim.cmd
+    uint32_t last;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+};
+
+static volatile struct latency_stats ssi_latency = { .min = UINT32_MAX };
+static volatile struct latency_stats sti_latency = { .min = UINT32_MAX };
+#if defined(SMODE_FORWARD)
+static volatile struct latency_stats sti_forward_latency = { .min = UINT32_MAX };
+// cycle when the M-mode MTI handler was entered
+static volatile uint32_t sti_forward_cycle = 0;
+#endif
+
+// Next supervisor timer compare value
+static volatile uint64_t timer_cmp = 0;
+// cycle when SSI was raised
+static volatile uint32_t ssi_raise_cycle = 0;
+
+// Count each supervisor interrupt
+static volatile uint32_t sti_count = 0;
+static volatile uint32_t ssi_count = 0;
+// Count each wakeup of the supervisor main loop
+static volatile uint64_t wakeup_count = 0;
+
+// Supervisor mode entry point, entered via mret from main()
+static void supervisor_main(void) __attribute__ ((noreturn));
+
+static void latency_record(volatile struct latency_stats *stats, uint32_t value);
+static void timer_request(void);
+static void ssi_raise(void);
+
+int main(void) {
+    // Global interrupt disable
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    csr_write_mie(0);
+
+    // Machine mode traps are still handled by the vector table
+    csr_write_mtvec((uint_xlen_t) riscv_mtvec_table | RISCV_MTVEC_MODE_VECTORED);
+
+#if defined(SMODE_FORWARD)
+    // No timer interrupt until S-mode requests one
+    mtimer_set_raw_time_cmp(UINT64_MAX >> 1);
+    // MSI and MTI trap to M-mode and are forwarded as SSI and STI.
+    // M-mode interrupts are enabled while in S-mode, regardless of mstatus.MIE.
+    csr_write_mie(MIE_MSI_BIT_MASK | MIE_MTI_BIT_MASK);
+#else
+    // Enable the Sstc extension (stimecmp), STI is raised without M-mode.
+#if (__riscv_xlen == 64)
+    csr_set_bits_menvcfg(MENVCFG_STCE_BIT_MASK);
+#else
+    csr_set_bits_menvcfgh(MENVCFGH_STCE_BIT_MASK);
+#endif
+#endif
+
+    // Drop to supervisor mode. SSI, STI and SEI are delegated, they trap directly to stvec.
+    smode_enter(supervisor_main,
+                (uint_xlen_t) riscv_stvec_table | SMODE_STVEC_MODE_VECTORED,
+                SMODE_MIDELEG_DEFAULT, SMODE_MEDELEG_DEFAULT);
+
+    // Will not reach here
+    return 0;
+}
+
+static void supervisor_main(void) {
+
+    // Setup timer for 1 millisecond interval
+    timer_cmp = mtimer_get_raw_time_csr() + TIMER_PERIOD;
+    timer_request();
+
+    // Enable SIE.STI and SIE.SSI
+    csr_set_bits_sie(SIE_STI_BIT_MASK | SIE_SSI_BIT_MASK);
+
+    // Supervisor global interrupt enable
+    csr_set_bits_sstatus(SSTATUS_SIE_BIT_MASK);
+
+    // Busy loop
+    do {
+        // Wait for timer interrupt
+        __asm__ volatile ("wfi");
+        wakeup_count++;
+        // Software interrupt to self, the handler measures the latency from here.
+        ssi_raise_cycle = (uint32_t)csr_read_cycle();
+        ssi_raise();
+    } while (1);
+}
+
+static void latency_record(volatile struct latency_stats *stats, uint32_t value) {
+    stats->count++;
+    stats->last = value;
+    if (value < stats->min) {
+        stats->min = value;
+    }
+    if (value > stats->max) {
+        stats->max = value;
+    }
+}
+
+#if defined(SMODE_FORWARD)
+
+// S-mode: Ask M-mode to raise STI at timer_cmp, as an SBI set_timer call.
+static void timer_request(void) {
+    __asm__ volatile ("ecall" ::: "memory");
+}
+
+// S-mode: Raise MSI via the CLINT, M-mode forwards it as SSI.
+static void ssi_raise(void) {
+    clint_set_msip(MTIMER_HART_ID);
+}
+
+// M-mode: Write mtimecmp without a spurious interrupt from an intermediate value.
+static void mtimecmp_write(uint64_t cmp) {
+    volatile uint32_t *mtimecmp = (volatile uint32_t *)(RISCV_MTIMECMP_HART_ADDR(MTIMER_HART_ID));
+    mtimecmp[1] = 0xFFFFFFFF;
+    mtimecmp[0] = (uint32_t)(cmp & 0x0FFFFFFFFUL);
+    mtimecmp[1] = (uint32_t)(cmp >> 32);
+}
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE.
+#pragma GCC optimize ("align-functions=4")
+// The 'riscv_mtvec_exception' function is added to the vector table by the vector_table.c
+// ecall from S-mode is the timer request: program mtimecmp, clear the forwarded STI and enable MTI again.
+void riscv_mtvec_exception(void) {
+    uint_xlen_t this_cause = csr_read_mcause();
+    if (this_cause == RISCV_EXCP_ENVIRONMENT_CALL_FROM_S_MODE) {
+        mtimecmp_write(timer_cmp);
+        csr_clr_bits_mip(MIP_STI_BIT_MASK);
+        csr_set_bits_mie(MIE_MTI_BIT_MASK);
+        // Make sure the return address is the instruction AFTER ecall
+        csr_write_mepc(csr_read_mepc() + 4);
+    }
+}
+// Forward the machine timer interrupt as STI. MTI stays masked until the next timer request.
+void riscv_mtvec_mti(void) {
+    sti_forward_cycle = (uint32_t)csr_read_mcycle();
+    csr_clr_bits_mie(MIE_MTI_BIT_MASK);
+    csr_set_bits_mip(MIP_STI_BIT_MASK);
+}
+// Forward the machine software interrupt as SSI.
+void riscv_mtvec_msi(void) {
+    clint_clr_msip(MTIMER_HART_ID);
+    csr_set_bits_mip(MIP_SSI_BIT_MASK);
+}
+#pragma GCC pop_options
+
+#else
+
+// S-mode: Program stimecmp, STI is raised at timer_cmp without M-mode.
+static void timer_request(void) {
+#if (__riscv_xlen == 64)
+    csr_write_stimecmp(timer_cmp);
+#else
+    // Prevent a spurious interrupt from an intermediate value
+    csr_write_stimecmph(0xFFFFFFFF);
+    csr_write_stimecmp((uint32_t)(timer_cmp & 0x0FFFFFFFFUL));
+    csr_write_stimecmph((uint32_t)(timer_cmp >> 32));
+#endif
+}
+
+// S-mode: SSI is delegated, S-mode can set sip.SSIP itself.
+static void ssi_raise(void) {
+    csr_set_bits_sip(SIP_SSI_BIT_MASK);
+}
+
+#endif // #if defined(SMODE_FORWARD)
+
+#pragma GCC push_options
+// Force the alignment for stvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+// The 'riscv_stvec_sti' function is added to the vector table by the vector_table.c
+void riscv_stvec_sti(void)  {
+    uint32_t cycle = (uint32_t)csr_read_cycle();
+    uint64_t now = mtimer_get_raw_time_csr();
+    latency_record(&sti_latency, (uint32_t)(now - timer_cmp));
+#if defined(SMODE_FORWARD)
+    latency_record(&sti_forward_latency, cycle - sti_forward_cycle);
+#else
+    (void)cycle;
+#endif
+    sti_count++;
+    // Next 1 millisecond tick, this also clears the pending interrupt.
+    timer_cmp += TIMER_PERIOD;
+    timer_request();
+}
+// The 'riscv_stvec_ssi' function is added to the vector table by the vector_table.c
+void riscv_stvec_ssi(void)  {
+    uint32_t cycle = (uint32_t)csr_read_cycle();
+    csr_clr_bits_sip(SIP_SSI_BIT_MASK);
+    latency_record(&ssi_latency, cycle - ssi_raise_cycle);
+    ssi_count++;
+}
+#pragma GCC pop_options
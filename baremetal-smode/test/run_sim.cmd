@@ -0,0 +1,26 @@
+echo on
+trace sti_count
+trace ssi_count
+trace wakeup_count
+until pc 0 main
+pc 0
+run 1000
+pc 0
+mem sti_count
+mem ssi_count
+mem wakeup_count
+run 20000
+pc 0
+mem sti_count
+mem ssi_count
+mem wakeup_count
+mem ssi_latency
+mem sti_latency
+run 20000
+mem sti_count
+mem ssi_count
+mem wakeup_count
+mem ssi_latency
+mem sti_latency
+
+q
@@ -0,0 +1,89 @@
+/*
+   Baremetal main program with a supervisor mode timer interrupt (Sstc).
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   Requires a core with S-mode and the Sstc extension.
+   Tested with the RISC-V ISA simulator.
+
+*/
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+#include "timer.h"
+#include "smode.h"
+
+#include "vector_table.h"
+
+// Global to hold current timestamp, written in STI handler.
+static volatile uint64_t timestamp = 0;
+
+// Count each supervisor timer interrupt
+static volatile uint32_t sti_count = 0;
+// Count each wakeup of the supervisor main loop
+static volatile uint64_t wakeup_count = 0;
+
+#define RISCV_MTVEC_MODE_VECTORED 1
+
+// Supervisor mode entry point, entered via mret from main()
+static void supervisor_main(void) __attribute__ ((noreturn));
+
+int main(void) {
+    // Global interrupt disable
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    csr_write_mie(0);
+
+    // Machine mode traps are still handled by the vector table
+    csr_write_mtvec((uint_xlen_t) riscv_mtvec_table | RISCV_MTVEC_MODE_VECTORED);
+
+    // Enable the Sstc extension (stimecmp). smode_enter() allows S-mode to read the time CSR.
+#if (__riscv_xlen == 64)
+    csr_set_bits_menvcfg(MENVCFG_STCE_BIT_MASK);
+#else
+    csr_set_bits_menvcfgh(MENVCFGH_STCE_BIT_MASK);
+#endif
+
+    // Drop to supervisor mode, the S-mode IRQ handler entry point is in vectored mode.
+    // Delegate the supervisor timer interrupt, it will not trap to M-mode.
+    smode_enter(supervisor_main,
+                (uint_xlen_t) riscv_stvec_table | SMODE_STVEC_MODE_VECTORED,
+                RISCV_INT_MASK_STI, 0);
+
+    // Will not reach here
+    return 0;
+}
+
+static void supervisor_main(void) {
+
+    // Setup timer for 1 millisecond interval
+    timestamp = mtimer_get_raw_time_csr();
+    stimer_set_raw_time_cmp(MTIMER_MSEC_TO_CLOCKS(1));
+
+    // Enable SIE.STI
+    csr_set_bits_sie(SIE_STI_BIT_MASK);
+
+    // Supervisor global interrupt enable
+    csr_set_bits_sstatus(SSTATUS_SIE_BIT_MASK);
+
+    // Busy loop
+    do {
+        // Wait for timer interrupt
+        __asm__ volatile ("wfi");
+        wakeup_count++;
+    } while (1);
+}
+
+#pragma GCC push_options
+// Force the alignment for stvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+// The 'riscv_stvec_sti' function is added to the vector table by the vector_table.c
+void riscv_stvec_sti(void)  {
+    sti_count++;
+    // Timer interrupt, re-program stimecmp for a 1 millisecond tick.
+    // Writing stimecmp clears the pending interrupt.
+    stimer_set_raw_time_cmp(MTIMER_MSEC_TO_CLOCKS(1));
+    timestamp = mtimer_get_raw_time_csr();
+}
+#pragma GCC pop_options
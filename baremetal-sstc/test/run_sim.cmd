@@ -0,0 +1,22 @@
+echo on
+trace timestamp
+trace sti_count
+trace wakeup_count
+until pc 0 main
+pc 0
+run 1000
+pc 0
+mem timestamp
+mem sti_count
+mem wakeup_count
+run 20000
+pc 0
+mem timestamp
+mem sti_count
+mem wakeup_count
+run 20000
+mem timestamp
+mem sti_count
+mem wakeup_count
+
+q
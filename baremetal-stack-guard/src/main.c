@@ -0,0 +1,96 @@
+/*
+   Baremetal main program with PMP guards below the stacks.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   Built with STARTUP_STACK_GUARD, startup.c locks a PMP region with no
+   permissions at the bottom of the main and interrupt stacks. The main
+   loop recurses one level deeper on each iteration until the main stack
+   overflows into the guard. The store access fault is reported by the
+   trap entry in stack_guard_fault_address and stack_guard_fault_pc.
+
+*/
+
+#include <stdint.h>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+#include "timer.h"
+
+#include "isr_stack.h"
+#include "stack_guard.h"
+
+// Bytes of locals in each recursion level
+#define RECURSE_WORDS 16
+
+// Results, traced by test/run_sim.cmd
+static volatile uint32_t mti_count = 0;
+static volatile uint32_t exception_count = 0;
+// Deepest recursion that returned
+static volatile uint32_t max_depth = 0;
+static volatile uint32_t recurse_result = 0;
+
+static uint32_t recurse(uint32_t depth);
+static void trap_handler(void);
+
+// Interrupts run on the interrupt stack, the stack guard check is ahead of them.
+ISR_STACK_ENTRY(isr_entry, trap_handler)
+STACK_GUARD_ENTRY(trap_entry, isr_entry)
+
+int main(void) {
+    // Global interrupt disable
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    csr_write_mie(0);
+
+    // Paint the stacks and point mscratch to the interrupt stack
+    isr_stack_init();
+
+    // Setup the IRQ handler entry point, direct mode
+    csr_write_mtvec((uint_xlen_t) trap_entry);
+
+    // Enable MIE.MTI
+    csr_set_bits_mie(MIE_MTI_BIT_MASK);
+
+    // Global interrupt enable
+    csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    // Setup timer for 1 msec interval
+    mtimer_set_raw_time_cmp(MTIMER_MSEC_TO_CLOCKS(1));
+
+    // Use more of the main stack on each iteration, until the guard is hit.
+    for (uint32_t depth = 1; ; depth++) {
+        recurse_result = recurse(depth);
+        max_depth = depth;
+    }
+
+    // Will not reach here
+    return 0;
+}
+
+static uint32_t recurse(uint32_t depth) {
+    volatile uint32_t locals[RECURSE_WORDS];
+    // Fill from the top, the order the stack is used, so the guard is hit
+    // before the memory below it.
+    for (int i = RECURSE_WORDS - 1; i >= 0; i--) {
+        locals[i] = depth;
+    }
+    if (depth == 0) {
+        return locals[0];
+    }
+    // Not a tail call, the frame is live across the call.
+    return recurse(depth - 1) + locals[RECURSE_WORDS - 1];
+}
+
+// Called via isr_entry on the interrupt stack
+static void trap_handler(void) {
+    uint_xlen_t cause = csr_read_mcause();
+    if (cause == (MCAUSE_INTERRUPT_BIT_MASK | RISCV_INT_POS_MTI)) {
+        mtimer_set_raw_time_cmp(MTIMER_MSEC_TO_CLOCKS(1));
+        mti_count++;
+    } else {
+        // Not expected, stack guard faults do not reach here.
+        exception_count++;
+    }
+}
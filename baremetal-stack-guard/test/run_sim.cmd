@@ -0,0 +1,14 @@
+echo on
+
+until pc 0 main
+pc 0
+
+run 100000
+mem max_depth
+mem mti_count
+mem stack_guard_fault_address
+mem stack_guard_fault_pc
+mem exception_count
+pc 0
+
+q
@@ -0,0 +1,82 @@
+/*
+   Deferred work queue, posted by interrupt handlers and run with interrupts enabled.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#include "riscv-csr.h"
+#include "timer.h"
+#include "deferred.h"
+
+#define DEFERRED_QUEUE_MASK (DEFERRED_QUEUE_SIZE - 1)
+
+// Producer and consumer are on the same hart, only the compiler may reorder the ring accesses.
+#define DEFERRED_BARRIER() __asm__ volatile ("" : : : "memory")
+
+struct deferred_queue deferred_queue;
+
+int deferred_post(deferred_fn_t fn, uintptr_t arg) {
+    uint32_t head = deferred_queue.head;
+    uint32_t pending = head - deferred_queue.tail;
+    if (pending >= DEFERRED_QUEUE_SIZE) {
+        deferred_queue.dropped++;
+        return -1;
+    }
+    deferred_queue.items[head & DEFERRED_QUEUE_MASK].fn = fn;
+    deferred_queue.items[head & DEFERRED_QUEUE_MASK].arg = arg;
+    // Publish the item after it is written
+    DEFERRED_BARRIER();
+    deferred_queue.head = head + 1;
+    if (pending >= deferred_queue.high_water) {
+        deferred_queue.high_water = pending + 1;
+    }
+#if !defined(DEFERRED_RUN_FROM_IDLE)
+    clint_set_msip(DEFERRED_HART_ID);
+#endif
+    return 0;
+}
+
+unsigned int deferred_run(void) {
+    unsigned int count = 0;
+    uint32_t tail = deferred_queue.tail;
+    while (tail != deferred_queue.head) {
+        // Read the item after head shows it was published
+        DEFERRED_BARRIER();
+        struct deferred_work work = deferred_queue.items[tail & DEFERRED_QUEUE_MASK];
+        // Release the slot before running, the work may be slow
+        DEFERRED_BARRIER();
+        deferred_queue.tail = ++tail;
+        work.fn(work.arg);
+        count++;
+    }
+    return count;
+}
+
+unsigned int deferred_idle(void) {
+    unsigned int count = deferred_run();
+    // Check the ring and wait with interrupts masked, so a post after the check still wakes wfi.
+    // wfi wakes on an enabled pending interrupt when mstatus.MIE is clear, it is taken once MIE is set.
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    if (deferred_queue.tail == deferred_queue.head) {
+        __asm__ volatile ("wfi");
+    }
+    csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    return count;
+}
+
+void deferred_run_msi(void) {
+    // A nested interrupt overwrites mepc and mstatus
+    uint_xlen_t mepc = csr_read_mepc();
+    uint_xlen_t mstatus = csr_read_mstatus();
+    // Work posted while running is found by deferred_run(), no need to take MSI again
+    clint_clr_msip(DEFERRED_HART_ID);
+    csr_clr_bits_mie(MIE_MSI_BIT_MASK);
+    csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    deferred_run();
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    csr_set_bits_mie(MIE_MSI_BIT_MASK);
+    csr_write_mepc(mepc);
+    csr_write_mstatus(mstatus);
+}
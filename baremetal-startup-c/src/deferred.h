@@ -0,0 +1,104 @@
+/*
+   Deferred work queue, posted by interrupt handlers and run with interrupts enabled.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef DEFERRED_H
+#define DEFERRED_H
+
+#include <stdint.h>
+
+/* An interrupt handler posts a work item (function and argument) to a
+   lock-free single producer, single consumer ring and returns. The
+   work is run later by deferred_run_msi() from the machine software
+   interrupt (MSI) handler, or by deferred_run() from the idle loop,
+   with interrupts enabled.
+
+   The producer is the interrupt handlers. They must not preempt each
+   other while posting, the default for the vector table handlers. With
+   VECTOR_TABLE_MTVEC_NESTED only handlers of the same nesting priority
+   may post. The consumer is either the MSI handler or the idle loop, not
+   both. Producer and consumer run on the same hart so a compiler barrier
+   is enough to order the ring accesses.
+
+   e.g. Defer the work of the timer interrupt:
+
+   void riscv_mtvec_mti(void) {
+       mtimer_set_raw_time_cmp(MTIMER_MSEC_TO_CLOCKS(1));
+       deferred_post(timer_work, mtimer_get_raw_time());
+   }
+   void riscv_mtvec_msi(void) {
+       deferred_run_msi();
+   }
+*/
+
+#ifndef DEFERRED_QUEUE_SIZE
+// Number of work items, must be a power of 2
+#define DEFERRED_QUEUE_SIZE 16
+#endif
+
+#if (DEFERRED_QUEUE_SIZE & (DEFERRED_QUEUE_SIZE - 1)) != 0
+#error "DEFERRED_QUEUE_SIZE must be a power of 2"
+#endif
+
+#ifndef DEFERRED_HART_ID
+// Hart ID of the msip register raised by deferred_post().
+#define DEFERRED_HART_ID 0
+#endif
+
+/* Define DEFERRED_RUN_FROM_IDLE when the idle loop calls deferred_idle().
+   deferred_post() then does not raise MSI, the interrupt that posted the
+   work already wakes the idle loop from wfi. deferred_idle() checks the
+   ring with interrupts masked before wfi, so work posted after the last
+   deferred_run() is not left waiting for the next interrupt.
+*/
+
+/** Deferred work function */
+typedef void (*deferred_fn_t)(uintptr_t arg);
+
+/** Work item */
+struct deferred_work {
+    deferred_fn_t fn;
+    uintptr_t arg;
+};
+
+/** Ring of work items. head is only written by the producer, tail only by the consumer. */
+struct deferred_queue {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    // Work items not posted as the ring was full
+    volatile uint32_t dropped;
+    // Maximum number of items waiting to run
+    volatile uint32_t high_water;
+    struct deferred_work items[DEFERRED_QUEUE_SIZE];
+};
+
+extern struct deferred_queue deferred_queue;
+
+/** Post work from an interrupt handler. Raises MSI unless DEFERRED_RUN_FROM_IDLE is defined.
+ * @return 0 on success, -1 if the ring is full and the work was dropped.
+ */
+int deferred_post(deferred_fn_t fn, uintptr_t arg);
+
+/** Run work items until the ring is empty.
+ * @return Number of work items run.
+ */
+unsigned int deferred_run(void);
+
+/** Body of the idle loop with DEFERRED_RUN_FROM_IDLE. Runs the work items, then waits
+ * with wfi if the ring is still empty. mstatus.MIE is clear from the check until wfi,
+ * and is set on return.
+ * @return Number of work items run.
+ */
+unsigned int deferred_idle(void);
+
+/** Body of the MSI handler. Clears msip and runs the work items with interrupts enabled.
+ * mepc and mstatus are saved and restored around the work, and MSI is masked while it runs.
+ * Can be called from riscv_mtvec_msi() with or without the interrupt ("machine") attribute.
+ */
+void deferred_run_msi(void);
+
+#endif // #ifdef DEFERRED_H
@@ -0,0 +1,53 @@
+/*
+   Dedicated interrupt stack, switched on trap entry via mscratch.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#include "riscv-csr.h"
+#include "isr_stack.h"
+#include "stack_guard.h"
+
+// Space left unpainted below the current stack pointer for this function
+#define ISR_STACK_PAINT_MARGIN 64
+
+static void isr_stack_paint(uint32_t *begin, uint32_t *end) {
+    for (volatile uint32_t *p = begin; p < end; p++) {
+        *p = ISR_STACK_PAINT;
+    }
+}
+
+// Stacks grow down, the usage is from the lowest overwritten word to the end.
+static size_t isr_stack_usage(const uint32_t *begin, const uint32_t *end) {
+    const volatile uint32_t *p = begin;
+    if (begin >= end) {
+        return 0;
+    }
+    while ((p < end) && (*p == ISR_STACK_PAINT)) {
+        p++;
+    }
+    return (size_t)((const uint8_t *)end - (const uint8_t *)p);
+}
+
+// The stack guard (stack_guard.h) is not painted or scanned, an access faults.
+void isr_stack_init(void) {
+    isr_stack_paint((uint32_t *)(&metal_segment_isr_stack_begin + STACK_GUARD_BYTES),
+                    (uint32_t *)&metal_segment_isr_stack_end);
+    // The main stack is in use, only paint below this frame
+    uint8_t *sp = (uint8_t *)__builtin_frame_address(0) - ISR_STACK_PAINT_MARGIN;
+    isr_stack_paint((uint32_t *)(&metal_segment_stack_begin + STACK_GUARD_BYTES),
+                    (uint32_t *)((uintptr_t)sp & ~(uintptr_t)3));
+    csr_write_mscratch((uint_xlen_t)&metal_segment_isr_stack_end);
+}
+
+size_t isr_stack_usage_main(void) {
+    return isr_stack_usage((const uint32_t *)(&metal_segment_stack_begin + STACK_GUARD_BYTES),
+                           (const uint32_t *)&metal_segment_stack_end);
+}
+
+size_t isr_stack_usage_isr(void) {
+    return isr_stack_usage((const uint32_t *)(&metal_segment_isr_stack_begin + STACK_GUARD_BYTES),
+                           (const uint32_t *)&metal_segment_isr_stack_end);
+}
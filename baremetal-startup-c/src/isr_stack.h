@@ -0,0 +1,140 @@
+/*
+   Dedicated interrupt stack, switched on trap entry via mscratch.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef ISR_STACK_H
+#define ISR_STACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* The interrupt stack is allocated by linker.lds, the size is set at link time:
+
+       -Xlinker --defsym=__isr_stack_size=0x400
+
+   The default size is 0, __isr_stack_size must be defined when the interrupt stack is used.
+
+   While no trap is being handled mscratch holds the top of the interrupt
+   stack. On entry sp and mscratch are swapped, and mscratch is set to 0
+   while the handler runs. A nested trap finds mscratch == 0 and stays on
+   the interrupt stack.
+
+   There is one interrupt stack, for hart 0. isr_stack_init() only sets
+   mscratch of the calling hart.
+*/
+
+// These symbols are defined by the linker script.
+// See linker.lds
+extern uint8_t metal_segment_stack_begin;
+extern uint8_t metal_segment_stack_end;
+extern uint8_t metal_segment_isr_stack_begin;
+extern uint8_t metal_segment_isr_stack_end;
+
+/** Fill pattern of unused stack memory, for the stack usage report */
+#define ISR_STACK_PAINT 0x5AA5A55AUL
+
+#if (__riscv_xlen == 64)
+#define ISR_STACK_STORE    "sd"
+#define ISR_STACK_LOAD     "ld"
+#define ISR_STACK_REGBYTES "8"
+#else
+#define ISR_STACK_STORE    "sw"
+#define ISR_STACK_LOAD     "lw"
+#define ISR_STACK_REGBYTES "4"
+#endif
+
+// Frame on the interrupt stack, the caller saved registers, the interrupted sp and the mscratch value to restore.
+// 20 registers keeps the stack 16 byte aligned for RV32 and RV64.
+#define ISR_STACK_FRAME        "20*" ISR_STACK_REGBYTES
+#define ISR_STACK_SLOT(N)      #N "*" ISR_STACK_REGBYTES "(sp);"
+#define ISR_STACK_SAVE(REG, N)    ISR_STACK_STORE " " #REG ", " ISR_STACK_SLOT(N)
+#define ISR_STACK_RESTORE(REG, N) ISR_STACK_LOAD  " " #REG ", " ISR_STACK_SLOT(N)
+
+/** Define a naked trap entry NAME that runs the plain C function HANDLER on the interrupt stack.
+    Use as the direct mode mtvec, or as the target of a vector table entry.
+    HANDLER must not be an interrupt ("machine") function, the entry saves the caller saved registers and returns with mret.
+    If HANDLER sets mstatus.MIE it must clear it again before returning.
+ */
+#define ISR_STACK_ENTRY(NAME, HANDLER)                                          \
+    void NAME(void) __attribute__ ((naked, aligned(4)));                        \
+    void NAME(void) {                                                           \
+        __asm__ volatile (                                                      \
+            "csrrw sp, mscratch, sp;"                                           \
+            "bnez  sp, 1f;"                                                     \
+            /* Nested trap, already on the interrupt stack. mscratch = 0 */     \
+            "csrrw sp, mscratch, sp;"                                           \
+            "addi  sp, sp, -" ISR_STACK_FRAME ";"                               \
+            ISR_STACK_SAVE(t0, 0)                                               \
+            "addi  t0, sp, " ISR_STACK_FRAME ";"                                \
+            ISR_STACK_SAVE(t0, 18)                                              \
+            ISR_STACK_SAVE(zero, 19)                                            \
+            "j     2f;"                                                         \
+            "1:"                                                                \
+            /* From the interrupted program. mscratch = interrupted sp */       \
+            "addi  sp, sp, -" ISR_STACK_FRAME ";"                               \
+            ISR_STACK_SAVE(t0, 0)                                               \
+            "addi  t0, sp, " ISR_STACK_FRAME ";"                                \
+            ISR_STACK_SAVE(t0, 19)                                              \
+            "csrrw t0, mscratch, zero;"                                         \
+            ISR_STACK_SAVE(t0, 18)                                              \
+            "2:"                                                                \
+            ISR_STACK_SAVE(ra, 1)                                               \
+            ISR_STACK_SAVE(t1, 2)                                               \
+            ISR_STACK_SAVE(t2, 3)                                               \
+            ISR_STACK_SAVE(t3, 4)                                               \
+            ISR_STACK_SAVE(t4, 5)                                               \
+            ISR_STACK_SAVE(t5, 6)                                               \
+            ISR_STACK_SAVE(t6, 7)                                               \
+            ISR_STACK_SAVE(a0, 8)                                               \
+            ISR_STACK_SAVE(a1, 9)                                               \
+            ISR_STACK_SAVE(a2, 10)                                              \
+            ISR_STACK_SAVE(a3, 11)                                              \
+            ISR_STACK_SAVE(a4, 12)                                              \
+            ISR_STACK_SAVE(a5, 13)                                              \
+            ISR_STACK_SAVE(a6, 14)                                              \
+            ISR_STACK_SAVE(a7, 15)                                              \
+            "call  %0;"                                                         \
+            ISR_STACK_RESTORE(ra, 1)                                            \
+            ISR_STACK_RESTORE(t1, 2)                                            \
+            ISR_STACK_RESTORE(t2, 3)                                            \
+            ISR_STACK_RESTORE(t3, 4)                                            \
+            ISR_STACK_RESTORE(t4, 5)                                            \
+            ISR_STACK_RESTORE(t5, 6)                                            \
+            ISR_STACK_RESTORE(t6, 7)                                            \
+            ISR_STACK_RESTORE(a0, 8)                                            \
+            ISR_STACK_RESTORE(a1, 9)                                            \
+            ISR_STACK_RESTORE(a2, 10)                                           \
+            ISR_STACK_RESTORE(a3, 11)                                           \
+            ISR_STACK_RESTORE(a4, 12)                                           \
+            ISR_STACK_RESTORE(a5, 13)                                           \
+            ISR_STACK_RESTORE(a6, 14)                                           \
+            ISR_STACK_RESTORE(a7, 15)                                           \
+            /* Top of the interrupt stack when leaving the outer trap, else 0 */\
+            ISR_STACK_RESTORE(t0, 19)                                           \
+            "csrw  mscratch, t0;"                                               \
+            ISR_STACK_RESTORE(t0, 0)                                            \
+            ISR_STACK_RESTORE(sp, 18)                                           \
+            "mret;"                                                             \
+            : /* output: none */                                                \
+            : /* input : immediate */ "i"(HANDLER)                              \
+            : /* clobbers: none */                                              \
+            );                                                                  \
+    }
+
+/** Paint the interrupt stack and the unused part of the main stack for the stack usage report,
+ * then set mscratch to the top of the interrupt stack.
+ * Call before enabling interrupts.
+ */
+void isr_stack_init(void);
+
+/** Maximum number of bytes used on the main stack since isr_stack_init() */
+size_t isr_stack_usage_main(void);
+
+/** Maximum number of bytes used on the interrupt stack since isr_stack_init() */
+size_t isr_stack_usage_isr(void);
+
+#endif // #ifdef ISR_STACK_H
@@ -16,10 +16,22 @@
 #include "riscv-csr.h"
 #include "riscv-interrupts.h"
 #include "timer.h"
+#include "trap_dispatch.h"
 
 // Machine mode interrupt service routine
 static void irq_entry(void) __attribute__ ((interrupt ("machine")));
 
+// Handlers called by irq_entry
+static void irq_mti(void);
+
+TRAP_DISPATCH_INTERRUPT_TABLE(irq_interrupts) = {
+    [0 ... TRAP_DISPATCH_INTERRUPTS-1] = trap_dispatch_nop,
+    [RISCV_INT_POS_MTI] = irq_mti,
+};
+TRAP_DISPATCH_EXCEPTION_TABLE(irq_exceptions) = {
+    [0 ... TRAP_DISPATCH_EXCEPTIONS-1] = trap_dispatch_nop,
+};
+
 // Constructors
 static void setup_global2(void) __attribute__ ((constructor(102)));
 static void setup_global1(void) __attribute__ ((constructor(101)));
@@ -92,22 +104,16 @@ int main(void) {
 #pragma GCC push_options
 // Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
 #pragma GCC optimize ("align-functions=4")
-static void irq_entry(void)  {
-    uint_xlen_t this_cause = csr_read_mcause();
-    if (this_cause &  MCAUSE_INTERRUPT_BIT_MASK) {
-        this_cause &= 0xFF;
-        // Known exceptions
-        switch (this_cause) {
-        case RISCV_INT_MASK_MTI :
-            // Timer exception, keep up the one second tick.
-            mtimer_set_raw_time_cmp(MTIMER_SECONDS_TO_CLOCKS(1));
-            timestamp = mtimer_get_raw_time();
-            break;
-        }
-    }
-}
+// Dispatch on mcause with the irq_interrupts and irq_exceptions tables
+TRAP_DISPATCH_ENTRY(irq_entry, irq_interrupts, irq_exceptions)
 #pragma GCC pop_options
 
+static void irq_mti(void) {
+    // Timer exception, keep up the one second tick.
+    mtimer_set_raw_time_cmp(MTIMER_SECONDS_TO_CLOCKS(1));
+    timestamp = mtimer_get_raw_time();
+}
+
 
 void setup_global2(void) {
     global_value1_with_constructor |= 0x200;
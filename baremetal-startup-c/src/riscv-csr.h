@@ -206,6 +206,18 @@ static inline uint_xlen_t csr_read_clr_bits_mstatus(uint_xlen_t mask) {
 #define MSTATUS_SPP_BIT_WIDTH    1
 #define MSTATUS_SPP_BIT_MASK     0x100
 #define MSTATUS_SPP_ALL_SET_MASK 0x1
+#define MSTATUS_FS_BIT_OFFSET   13
+#define MSTATUS_FS_BIT_WIDTH    2
+#define MSTATUS_FS_BIT_MASK     0x6000
+#define MSTATUS_FS_ALL_SET_MASK 0x3
+#define MSTATUS_XS_BIT_OFFSET   15
+#define MSTATUS_XS_BIT_WIDTH    2
+#define MSTATUS_XS_BIT_MASK     0x18000
+#define MSTATUS_XS_ALL_SET_MASK 0x3
+#define MSTATUS_SD_BIT_OFFSET   (__riscv_xlen-1)
+#define MSTATUS_SD_BIT_WIDTH    1
+#define MSTATUS_SD_BIT_MASK     (0x1UL << ((__riscv_xlen-1)))
+#define MSTATUS_SD_ALL_SET_MASK 0x1
 
 /*******************************************
  * mstatush - MRW - Additional machine status register, RV32 only. 
@@ -3788,4 +3800,214 @@ static inline uint_xlen_t csr_read_write_mtval2(uint_xlen_t new_value) {
 }
 
 
+/*******************************************
+ * stimecmp - SRW - Supervisor Timer Compare (Sstc) 
+ */
+static inline uint64_t csr_read_stimecmp(void) {
+    uint_csr64_t value;        
+    __asm__ volatile ("csrr    %0, stimecmp" 
+                      : "=r" (value)  /* output : register */
+                      : /* input : none */
+                      : /* clobbers: none */);
+    return value;
+}
+static inline void csr_write_stimecmp(uint_csr64_t value) {
+    __asm__ volatile ("csrw    stimecmp, %0" 
+                      : /* output: none */ 
+                      : "r" (value) /* input : from register */
+                      : /* clobbers: none */);
+}
+static inline uint64_t csr_read_write_stimecmp(uint64_t new_value) {
+    uint_csr64_t prev_value;
+    __asm__ volatile ("csrrw    %0, stimecmp, %1"  
+                      : "=r" (prev_value) /* output: register %0 */
+                      : "r" (new_value)  /* input : register */
+                      : /* clobbers: none */);
+    return prev_value;
+}
+
+/*******************************************
+ * stimecmph - SRW - Upper 32 bits of  stimecmp, RV32 only. 
+ */
+static inline uint32_t csr_read_stimecmph(void) {
+    uint_csr32_t value;        
+    __asm__ volatile ("csrr    %0, stimecmph" 
+                      : "=r" (value)  /* output : register */
+                      : /* input : none */
+                      : /* clobbers: none */);
+    return value;
+}
+static inline void csr_write_stimecmph(uint_csr32_t value) {
+    __asm__ volatile ("csrw    stimecmph, %0" 
+                      : /* output: none */ 
+                      : "r" (value) /* input : from register */
+                      : /* clobbers: none */);
+}
+static inline uint32_t csr_read_write_stimecmph(uint32_t new_value) {
+    uint_csr32_t prev_value;
+    __asm__ volatile ("csrrw    %0, stimecmph, %1"  
+                      : "=r" (prev_value) /* output: register %0 */
+                      : "r" (new_value)  /* input : register */
+                      : /* clobbers: none */);
+    return prev_value;
+}
+
+/*******************************************
+ * menvcfg - MRW - Machine Environment Configuration 
+ */
+static inline uint64_t csr_read_menvcfg(void) {
+    uint_csr64_t value;        
+    __asm__ volatile ("csrr    %0, menvcfg" 
+                      : "=r" (value)  /* output : register */
+                      : /* input : none */
+                      : /* clobbers: none */);
+    return value;
+}
+static inline void csr_write_menvcfg(uint_csr64_t value) {
+    __asm__ volatile ("csrw    menvcfg, %0" 
+                      : /* output: none */ 
+                      : "r" (value) /* input : from register */
+                      : /* clobbers: none */);
+}
+static inline uint64_t csr_read_write_menvcfg(uint_csr64_t new_value) {
+    uint_csr64_t prev_value;
+    __asm__ volatile ("csrrw    %0, menvcfg, %1"  
+                      : "=r" (prev_value) /* output: register %0 */
+                      : "r" (new_value)  /* input : register */
+                      : /* clobbers: none */);
+    return prev_value;
+}
+/* Register CSR bit set and clear instructions */
+static inline void csr_set_bits_menvcfg(uint_csr64_t mask) {
+    __asm__ volatile ("csrrs    zero, menvcfg, %0"  
+                      : /* output: none */ 
+                      : "r" (mask)  /* input : register */
+                      : /* clobbers: none */);
+}
+static inline void csr_clr_bits_menvcfg(uint_csr64_t mask) {
+    __asm__ volatile ("csrrc    zero, menvcfg, %0"  
+                      : /* output: none */ 
+                      : "r" (mask)  /* input : register */
+                      : /* clobbers: none */);
+}
+static inline uint64_t csr_read_set_bits_menvcfg(uint_csr64_t mask) {
+    uint_csr64_t value;
+    __asm__ volatile ("csrrs    %0, menvcfg, %1"  
+                      : "=r" (value) /* output: register %0 */
+                      : "r" (mask)  /* input : register */
+                      : /* clobbers: none */);
+    return value;
+}
+static inline uint64_t csr_read_clr_bits_menvcfg(uint_csr64_t mask) {
+    uint_csr64_t value;
+    __asm__ volatile ("csrrc    %0, menvcfg, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+    return value;
+}
+/* menvcfg, CSR write value via immediate value (only up to 5 bits) */
+#define CSR_WRITE_IMM_MENVCFG(VALUE)                    \
+    __asm__ volatile ("csrrwi    zero, menvcfg, %0"           \
+                      : /* output: none */                         \
+                      : "i" (VALUE)  /* input : immediate  */      \
+                      : /* clobbers: none */)
+
+/* menvcfg, CSR set bits via immediate value mask (only up to 5 bits) */
+#define CSR_SET_BITS_IMM_MENVCFG(MASK)                 \
+    __asm__ volatile ("csrrsi    zero, menvcfg, %0"          \
+                      : /* output: none */                        \
+                      : "i" (MASK)  /* input : immediate  */      \
+                      : /* clobbers: none */)
+
+/* menvcfg, CSR clear bits via immediate value mask (only up to 5 bits) */
+#define CSR_CLR_BITS_IMM_MENVCFG(MASK)               \
+    __asm__ volatile ("csrrci    zero, menvcfg, %0"        \
+                      : /* output: none */                      \
+                      : "i" (MASK)  /* input : immediate */     \
+                      : /* clobbers: none */)
+#define MENVCFG_STCE_BIT_OFFSET   63
+#define MENVCFG_STCE_BIT_WIDTH    1
+#define MENVCFG_STCE_BIT_MASK     0x8000000000000000
+#define MENVCFG_STCE_ALL_SET_MASK 0x1
+
+/*******************************************
+ * menvcfgh - MRW - Upper 32 bits of  menvcfg, RV32 only. 
+ */
+static inline uint32_t csr_read_menvcfgh(void) {
+    uint_csr32_t value;        
+    __asm__ volatile ("csrr    %0, menvcfgh" 
+                      : "=r" (value)  /* output : register */
+                      : /* input : none */
+                      : /* clobbers: none */);
+    return value;
+}
+static inline void csr_write_menvcfgh(uint_csr32_t value) {
+    __asm__ volatile ("csrw    menvcfgh, %0" 
+                      : /* output: none */ 
+                      : "r" (value) /* input : from register */
+                      : /* clobbers: none */);
+}
+static inline uint32_t csr_read_write_menvcfgh(uint32_t new_value) {
+    uint_csr32_t prev_value;
+    __asm__ volatile ("csrrw    %0, menvcfgh, %1"  
+                      : "=r" (prev_value) /* output: register %0 */
+                      : "r" (new_value)  /* input : register */
+                      : /* clobbers: none */);
+    return prev_value;
+}
+/* Register CSR bit set and clear instructions */
+static inline void csr_set_bits_menvcfgh(uint32_t mask) {
+    __asm__ volatile ("csrrs    zero, menvcfgh, %0"  
+                      : /* output: none */ 
+                      : "r" (mask)  /* input : register */
+                      : /* clobbers: none */);
+}
+static inline void csr_clr_bits_menvcfgh(uint32_t mask) {
+    __asm__ volatile ("csrrc    zero, menvcfgh, %0"  
+                      : /* output: none */ 
+                      : "r" (mask)  /* input : register */
+                      : /* clobbers: none */);
+}
+static inline uint32_t csr_read_set_bits_menvcfgh(uint32_t mask) {
+    uint_csr32_t value;
+    __asm__ volatile ("csrrs    %0, menvcfgh, %1"  
+                      : "=r" (value) /* output: register %0 */
+                      : "r" (mask)  /* input : register */
+                      : /* clobbers: none */);
+    return value;
+}
+static inline uint32_t csr_read_clr_bits_menvcfgh(uint32_t mask) {
+    uint_csr32_t value;
+    __asm__ volatile ("csrrc    %0, menvcfgh, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+    return value;
+}
+/* menvcfgh, CSR write value via immediate value (only up to 5 bits) */
+#define CSR_WRITE_IMM_MENVCFGH(VALUE)                    \
+    __asm__ volatile ("csrrwi    zero, menvcfgh, %0"           \
+                      : /* output: none */                         \
+                      : "i" (VALUE)  /* input : immediate  */      \
+                      : /* clobbers: none */)
+
+/* menvcfgh, CSR set bits via immediate value mask (only up to 5 bits) */
+#define CSR_SET_BITS_IMM_MENVCFGH(MASK)                 \
+    __asm__ volatile ("csrrsi    zero, menvcfgh, %0"          \
+                      : /* output: none */                        \
+                      : "i" (MASK)  /* input : immediate  */      \
+                      : /* clobbers: none */)
+
+/* menvcfgh, CSR clear bits via immediate value mask (only up to 5 bits) */
+#define CSR_CLR_BITS_IMM_MENVCFGH(MASK)               \
+    __asm__ volatile ("csrrci    zero, menvcfgh, %0"        \
+                      : /* output: none */                      \
+                      : "i" (MASK)  /* input : immediate */     \
+                      : /* clobbers: none */)
+#define MENVCFGH_STCE_BIT_OFFSET   31
+#define MENVCFGH_STCE_BIT_WIDTH    1
+#define MENVCFGH_STCE_BIT_MASK     0x80000000
+#define MENVCFGH_STCE_ALL_SET_MASK 0x1
+
 #endif // #define RISCV_CSR_H
@@ -0,0 +1,104 @@
+/*
+   Sequence lock for state shared between interrupt handlers and the main program.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+
+/* A sequence counter protecting one or more variables that are written
+   by interrupt handlers and read as a consistent set by the main program,
+   without disabling interrupts.
+
+   The writer increments the sequence before and after the update, it
+   never waits. The reader copies the variables and retries if the
+   sequence was odd or changed during the copy. On RV32 this gives a tear
+   free read of a uint64_t, or of several counters updated together.
+
+   Writers and readers must be on the same hart, a compiler barrier orders
+   the accesses. Nested writers are allowed, they complete before the main
+   program resumes. Do not read from an interrupt handler that may preempt
+   a writer.
+
+   e.g.
+
+   static seqlock_t counters_seq;
+   static volatile uint64_t timestamp;
+   static volatile uint32_t mti_count;
+
+   // Interrupt handler
+   SEQLOCK_WRITE(counters_seq, {
+       timestamp = mtimer_get_raw_time();
+       mti_count++;
+   });
+
+   // Main program
+   uint64_t now;
+   uint32_t count;
+   SEQLOCK_READ(counters_seq, {
+       now = timestamp;
+       count = mti_count;
+   });
+*/
+
+/** Sequence counter, even when no write is in progress */
+typedef volatile uint32_t seqlock_t;
+
+#define SEQLOCK_BARRIER() __asm__ volatile ("" : : : "memory")
+
+/** Start a write. Call from the writer (interrupt handler). */
+static inline void seqlock_write_begin(seqlock_t *seq) {
+    *seq = *seq + 1;
+    SEQLOCK_BARRIER();
+}
+
+/** Complete a write. */
+static inline void seqlock_write_end(seqlock_t *seq) {
+    SEQLOCK_BARRIER();
+    *seq = *seq + 1;
+}
+
+/** Start a read, waits for an even sequence.
+ * @return Sequence to pass to seqlock_read_retry()
+ */
+static inline uint32_t seqlock_read_begin(const seqlock_t *seq) {
+    uint32_t start;
+    do {
+        start = *seq;
+    } while (start & 1);
+    SEQLOCK_BARRIER();
+    return start;
+}
+
+/** End a read.
+ * @return Non-zero if a write overlapped the read and it must be repeated.
+ */
+static inline int seqlock_read_retry(const seqlock_t *seq, uint32_t start) {
+    SEQLOCK_BARRIER();
+    return *seq != start;
+}
+
+/** Run the statement after SEQ as a write of the variables protected by SEQ. */
+#define SEQLOCK_WRITE(SEQ, ...)                         \
+    do {                                                \
+        seqlock_write_begin(&(SEQ));                    \
+        __VA_ARGS__;                                    \
+        seqlock_write_end(&(SEQ));                      \
+    } while (0)
+
+/** Run the statement after SEQ to copy the variables protected by SEQ, repeated until no write overlapped it. */
+#define SEQLOCK_READ(SEQ, ...)                                  \
+    do {                                                        \
+        uint32_t seqlock_start_;                                \
+        do {                                                    \
+            seqlock_start_ = seqlock_read_begin(&(SEQ));        \
+            __VA_ARGS__;                                        \
+        } while (seqlock_read_retry(&(SEQ), seqlock_start_));   \
+    } while (0)
+
+#endif // #ifdef SEQLOCK_H
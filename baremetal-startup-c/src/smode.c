@@ -0,0 +1,46 @@
+/*
+   Boot from machine mode to supervisor mode with delegated traps.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#include "riscv-csr.h"
+#include "smode.h"
+
+// Value for mstatus.MPP to return to supervisor mode
+#define SMODE_PRIV_MODE_S 1
+
+// PMP configuration, NAPOT region with read, write and execute permission
+#define SMODE_PMPCFG_RWX_NAPOT 0x1F
+
+void smode_enter(void (*entry)(void), uint_xlen_t stvec, uint_xlen_t mideleg, uint_xlen_t medeleg) {
+    // Allow S-mode to access all memory with the last entry, 15.
+    // The lower entries have priority, e.g. the stack guards (stack_guard.h).
+    csr_write_pmpaddr15((uint_xlen_t)-1);
+#if (__riscv_xlen == 64)
+    csr_write_pmpcfg2((csr_read_pmpcfg2() & ~((uint_xlen_t)0xFF << 56)) | ((uint_xlen_t)SMODE_PMPCFG_RWX_NAPOT << 56));
+#else
+    csr_write_pmpcfg3((csr_read_pmpcfg3() & ~((uint_xlen_t)0xFF << 24)) | ((uint_xlen_t)SMODE_PMPCFG_RWX_NAPOT << 24));
+#endif
+
+    csr_write_mcounteren(SMODE_MCOUNTEREN_DEFAULT);
+
+    // Delegated traps go directly to stvec
+    csr_write_mideleg(mideleg);
+    csr_write_medeleg(medeleg);
+    csr_write_stvec(stvec);
+
+    // S-mode interrupts are enabled by the S-mode program
+    csr_clr_bits_sstatus(SSTATUS_SIE_BIT_MASK);
+
+    // Drop to supervisor mode
+    csr_clr_bits_mstatus(MSTATUS_MPP_BIT_MASK);
+    csr_set_bits_mstatus(SMODE_PRIV_MODE_S << MSTATUS_MPP_BIT_OFFSET);
+    csr_write_mepc((uint_xlen_t) entry);
+    __asm__ volatile ("mret");
+
+    // Will not reach here
+    __builtin_unreachable();
+}
@@ -0,0 +1,62 @@
+/*
+   Boot from machine mode to supervisor mode with delegated traps.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef SMODE_H
+#define SMODE_H
+
+#include <stdint.h>
+
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+
+/* A trap delegated with mideleg/medeleg is taken directly in S-mode,
+   via stvec. A trap that is not delegated enters M-mode first, and is
+   only seen by S-mode if the M-mode handler forwards it, e.g. by setting
+   mip.STIP or mip.SSIP. The forwarded path costs an extra trap entry,
+   context save and mret for each event.
+
+   M-mode interrupts are always enabled while the hart runs in S-mode,
+   regardless of mstatus.MIE, so M-mode handlers still run.
+*/
+
+/** Interrupts handled by S-mode: software, timer and external. */
+#define SMODE_MIDELEG_DEFAULT                   \
+    (RISCV_INT_MASK_SSI                         \
+     | RISCV_INT_MASK_STI                       \
+     | RISCV_INT_MASK_SEI)
+
+/** Exceptions handled by S-mode. ecall from S-mode is not delegated, it is the call into M-mode. */
+#define SMODE_MEDELEG_DEFAULT                                           \
+    ((1UL << RISCV_EXCP_INSTRUCTION_ADDRESS_MISALIGNED)                 \
+     | (1UL << RISCV_EXCP_BREAKPOINT)                                   \
+     | (1UL << RISCV_EXCP_ENVIRONMENT_CALL_FROM_U_MODE)                 \
+     | (1UL << RISCV_EXCP_INSTRUCTION_PAGE_FAULT)                       \
+     | (1UL << RISCV_EXCP_LOAD_PAGE_FAULT)                              \
+     | (1UL << RISCV_EXCP_STORE_AMO_PAGE_FAULT))
+
+/** stvec.MODE for a vectored table, e.g. riscv_stvec_table */
+#define SMODE_STVEC_MODE_VECTORED 1
+
+/** Counters S-mode may read: cycle, time and instret */
+#define SMODE_MCOUNTEREN_DEFAULT                                        \
+    (MCOUNTEREN_CY_BIT_MASK | MCOUNTEREN_TM_BIT_MASK | MCOUNTEREN_IR_BIT_MASK)
+
+/** Leave M-mode and run 'entry' in S-mode.
+ * @param entry S-mode entry point, it must not return.
+ * @param stvec Trap vector for S-mode, including the mode bits.
+ * @param mideleg Interrupts to delegate to S-mode.
+ * @param medeleg Exceptions to delegate to S-mode.
+ * @note PMP entry 15 is set to allow S-mode access to all memory, otherwise
+ * every S-mode access faults when PMP is implemented. Entries 0 to 14 are
+ * left for regions that take priority, e.g. the stack guards (stack_guard.h).
+ * mcounteren is set to SMODE_MCOUNTEREN_DEFAULT.
+ * Set up mtvec and the M-mode interrupts that are not delegated before calling.
+ */
+void smode_enter(void (*entry)(void), uint_xlen_t stvec, uint_xlen_t mideleg, uint_xlen_t medeleg) __attribute__ ((noreturn));
+
+#endif // #ifdef SMODE_H
@@ -0,0 +1,46 @@
+/*
+   PMP guard regions below the main and interrupt stacks.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#include "riscv-csr.h"
+#include "stack_guard.h"
+
+// pmpaddr holds bits [XLEN+1:2] of the address, NAPOT encodes the size in the trailing 1s.
+#if (STACK_GUARD_SIZE == 4)
+#define STACK_GUARD_PMPCFG   (STACK_GUARD_PMPCFG_L | STACK_GUARD_PMPCFG_NA4)
+#define STACK_GUARD_PMPADDR(BASE) ((uint_xlen_t)(BASE) >> 2)
+#else
+#define STACK_GUARD_PMPCFG   (STACK_GUARD_PMPCFG_L | STACK_GUARD_PMPCFG_NAPOT)
+#define STACK_GUARD_PMPADDR(BASE) (((uint_xlen_t)(BASE) | (STACK_GUARD_SIZE / 2 - 1)) >> 2)
+#endif
+
+uint8_t stack_guard_fault_stack[STACK_GUARD_FAULT_STACK_SIZE] __attribute__ ((aligned(16)));
+
+volatile uintptr_t stack_guard_fault_address = 0;
+volatile uintptr_t stack_guard_fault_pc = 0;
+
+void stack_guard_init(void) {
+    uint_xlen_t pmpcfg = STACK_GUARD_PMPCFG;
+    csr_write_pmpaddr0(STACK_GUARD_PMPADDR(&metal_segment_stack_begin));
+    if (&metal_segment_isr_stack_end != &metal_segment_isr_stack_begin) {
+        csr_write_pmpaddr1(STACK_GUARD_PMPADDR(&metal_segment_isr_stack_begin));
+        pmpcfg |= STACK_GUARD_PMPCFG << 8;
+    }
+    // Entries 0 and 1, the address is set before the entry is enabled and locked.
+    csr_write_pmpcfg0((csr_read_pmpcfg0() & ~(uint_xlen_t)0xFFFF) | pmpcfg);
+    // No interrupt stack yet, STACK_GUARD_ENTRY() uses stack_guard_fault_stack.
+    csr_write_mscratch(0);
+}
+
+void __attribute__ ((weak)) stack_guard_overflow(uintptr_t address, uintptr_t pc) {
+    stack_guard_fault_address = address;
+    stack_guard_fault_pc = pc;
+    // Halt
+    while (1) {
+        __asm__ volatile ("wfi");
+    }
+}
@@ -0,0 +1,186 @@
+/*
+   PMP guard regions below the main and interrupt stacks.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef STACK_GUARD_H
+#define STACK_GUARD_H
+
+#include <stdint.h>
+
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+
+/* The stacks grow down. linker.lds places the main stack directly above
+   .bss, and the interrupt stack (isr_stack.h) directly above the main
+   stack, so an overflow silently overwrites global variables or the
+   other stack.
+
+   stack_guard_init() makes the lowest STACK_GUARD_SIZE bytes of each
+   stack a locked PMP region with no permissions, an NA4 region for 4
+   bytes, otherwise NAPOT:
+
+   - PMP entry 0: metal_segment_stack_begin
+   - PMP entry 1: metal_segment_isr_stack_begin, if __isr_stack_size is not 0
+
+   A locked entry also applies to M-mode, and can not be changed until
+   reset. A load or store in the guard is a load or store/AMO access
+   fault. There is no code added to each function, unlike the canaries
+   of -fstack-protector. A frame larger than the guard may skip over it.
+
+   When built with STARTUP_STACK_GUARD, startup.c calls stack_guard_init()
+   before the C runtime is initialized.
+
+   The fault can not be handled on the overflowed stack. The trap entry
+   defined by STACK_GUARD_ENTRY() uses the interrupt stack from mscratch
+   (see isr_stack.h), or a small fault stack when mscratch is 0, checks
+   mtval against the guards and calls stack_guard_overflow(). Any other
+   trap jumps to OTHER with all registers intact.
+
+   Usage, as the direct mode mtvec, or as the exception vector:
+
+   ISR_STACK_ENTRY(isr_entry, trap_handler)
+   STACK_GUARD_ENTRY(trap_entry, isr_entry)
+
+   csr_write_mtvec((uint_xlen_t) trap_entry);
+*/
+
+#ifndef STACK_GUARD_SIZE
+// Size of each guard region. 4 (NA4), 8 or 16 (NAPOT), the stacks are 16 byte aligned by linker.lds.
+#define STACK_GUARD_SIZE 16
+#endif
+
+#if (STACK_GUARD_SIZE != 4) && (STACK_GUARD_SIZE != 8) && (STACK_GUARD_SIZE != 16)
+#error "STACK_GUARD_SIZE must be 4, 8 or 16"
+#endif
+
+#if defined(STARTUP_STACK_GUARD)
+// Bytes at the bottom of each stack that can not be accessed
+#define STACK_GUARD_BYTES STACK_GUARD_SIZE
+#else
+#define STACK_GUARD_BYTES 0
+#endif
+
+#ifndef STACK_GUARD_FAULT_STACK_SIZE
+// Stack used to report an overflow when mscratch is 0
+#define STACK_GUARD_FAULT_STACK_SIZE 256
+#endif
+
+// PMP configuration byte, locked, no permissions
+#define STACK_GUARD_PMPCFG_L     0x80
+#define STACK_GUARD_PMPCFG_NA4   0x10
+#define STACK_GUARD_PMPCFG_NAPOT 0x18
+
+// These symbols are defined by the linker script.
+// See linker.lds
+extern uint8_t metal_segment_stack_begin;
+extern uint8_t metal_segment_isr_stack_begin;
+extern uint8_t metal_segment_isr_stack_end;
+
+/** Stack for the overflow report, the top is used by STACK_GUARD_ENTRY(). */
+extern uint8_t stack_guard_fault_stack[STACK_GUARD_FAULT_STACK_SIZE];
+
+/** Address and pc of the access that hit a guard, set by the default stack_guard_overflow(). */
+extern volatile uintptr_t stack_guard_fault_address;
+extern volatile uintptr_t stack_guard_fault_pc;
+
+#if (__riscv_xlen == 64)
+#define STACK_GUARD_STORE    "sd"
+#define STACK_GUARD_LOAD     "ld"
+#define STACK_GUARD_REGBYTES "8"
+#define STACK_GUARD_FRAME    "32"
+#else
+#define STACK_GUARD_STORE    "sw"
+#define STACK_GUARD_LOAD     "lw"
+#define STACK_GUARD_REGBYTES "4"
+#define STACK_GUARD_FRAME    "16"
+#endif
+
+#define STACK_GUARD_STR_(X) #X
+#define STACK_GUARD_STR(X) STACK_GUARD_STR_(X)
+
+#define STACK_GUARD_SLOT(N)         #N "*" STACK_GUARD_REGBYTES "(sp);"
+#define STACK_GUARD_SAVE(REG, N)    STACK_GUARD_STORE " " #REG ", " STACK_GUARD_SLOT(N)
+#define STACK_GUARD_RESTORE(REG, N) STACK_GUARD_LOAD  " " #REG ", " STACK_GUARD_SLOT(N)
+
+/** Define a naked trap entry NAME that reports a stack overflow, and
+    passes any other trap to OTHER, a naked or interrupt ("machine")
+    function with external linkage.
+
+    Frame: 0: t0, 1: t1, 2: t2, 3: mscratch to restore, then the interrupted sp.
+    mscratch holds the interrupted sp while the guard is checked.
+*/
+#define STACK_GUARD_ENTRY(NAME, OTHER)                                          \
+    void NAME(void) __attribute__ ((naked, aligned(4)));                        \
+    void NAME(void) {                                                           \
+        __asm__ volatile (                                                      \
+            "csrrw sp, mscratch, sp;"                                           \
+            "bnez  sp, 1f;"                                                     \
+            /* In a trap, or no interrupt stack. mscratch = 0 */                \
+            "la    sp, stack_guard_fault_stack + "                              \
+                   STACK_GUARD_STR(STACK_GUARD_FAULT_STACK_SIZE) ";"            \
+            "addi  sp, sp, -" STACK_GUARD_FRAME ";"                             \
+            STACK_GUARD_SAVE(t0, 0)                                             \
+            STACK_GUARD_SAVE(zero, 3)                                           \
+            "j     2f;"                                                         \
+            "1:"                                                                \
+            /* From the program, on the idle interrupt stack */                 \
+            "addi  sp, sp, -" STACK_GUARD_FRAME ";"                             \
+            STACK_GUARD_SAVE(t0, 0)                                             \
+            "addi  t0, sp, " STACK_GUARD_FRAME ";"                              \
+            STACK_GUARD_SAVE(t0, 3)                                             \
+            "2:"                                                                \
+            STACK_GUARD_SAVE(t1, 1)                                             \
+            STACK_GUARD_SAVE(t2, 2)                                             \
+            /* Load or store/AMO access fault, cause 5 or 7 */                  \
+            "csrr  t0, mcause;"                                                 \
+            "addi  t0, t0, -5;"                                                 \
+            "beqz  t0, 3f;"                                                     \
+            "addi  t0, t0, -2;"                                                 \
+            "bnez  t0, 4f;"                                                     \
+            "3:"                                                                \
+            "csrr  t0, mtval;"                                                  \
+            "la    t1, metal_segment_stack_begin;"                              \
+            "sub   t1, t0, t1;"                                                 \
+            "sltiu t1, t1, " STACK_GUARD_STR(STACK_GUARD_SIZE) ";"              \
+            "bnez  t1, 5f;"                                                     \
+            "la    t1, metal_segment_isr_stack_begin;"                          \
+            "la    t2, metal_segment_isr_stack_end;"                            \
+            "beq   t1, t2, 4f;"                                                 \
+            "sub   t1, t0, t1;"                                                 \
+            "sltiu t1, t1, " STACK_GUARD_STR(STACK_GUARD_SIZE) ";"              \
+            "beqz  t1, 4f;"                                                     \
+            "5:"                                                                \
+            /* Overflow, does not return */                                     \
+            "mv    a0, t0;"                                                     \
+            "csrr  a1, mepc;"                                                   \
+            "call  stack_guard_overflow;"                                       \
+            "4:"                                                                \
+            /* Not a guard, restore mscratch and the interrupted sp */          \
+            STACK_GUARD_RESTORE(t1, 1)                                          \
+            STACK_GUARD_RESTORE(t2, 2)                                          \
+            STACK_GUARD_RESTORE(t0, 3)                                          \
+            "csrrw t0, mscratch, t0;"                                           \
+            STACK_GUARD_SAVE(t0, 3)                                             \
+            STACK_GUARD_RESTORE(t0, 0)                                          \
+            STACK_GUARD_RESTORE(sp, 3)                                          \
+            "j     " #OTHER ";"                                                 \
+            );                                                                  \
+    }
+
+/** Program the locked PMP guard entries 0 and 1, and set mscratch to 0.
+ * Call before the stacks can overflow, e.g. from startup.c with STARTUP_STACK_GUARD.
+ * isr_stack_init() may be called later to set mscratch to the interrupt stack.
+ */
+void stack_guard_init(void);
+
+/** Called by STACK_GUARD_ENTRY() on a guard access, with the fault address and pc.
+ * The default (weak) implementation sets stack_guard_fault_address and
+ * stack_guard_fault_pc, then halts. The interrupted program can not be resumed.
+ */
+void stack_guard_overflow(uintptr_t address, uintptr_t pc) __attribute__ ((noreturn));
+
+#endif // #ifdef STACK_GUARD_H
@@ -9,6 +9,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(STARTUP_STACK_GUARD)
+#include "stack_guard.h"
+#endif
+
 // Generic C function pointer.
 typedef void(*function_t)(void) ;
 
@@ -65,6 +69,11 @@ void _enter(void) {
 // At this point we have a stack and global poiner, but no access to global variables.
 void _start(void) {
 
+#if defined(STARTUP_STACK_GUARD)
+    // PMP guards below the stacks, before any global variable is written
+    stack_guard_init();
+#endif
+
     // Init memory regions
     // Clear the .bss section (global variables with no initial values)
     memset((void*) &metal_segment_bss_target_start,
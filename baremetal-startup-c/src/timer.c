@@ -8,16 +8,30 @@
 
 #include "timer.h"
 
+#if defined(MTIMER_LATENCY_STATS)
+volatile struct mtimer_latency_stats mtimer_latency;
+#endif
+
 void mtimer_set_raw_time_cmp(uint64_t clock_offset) {
+    mtimer_set_hart_raw_time_cmp(MTIMER_HART_ID, clock_offset);
+}
+
+void mtimer_set_hart_raw_time_cmp(uint_xlen_t hart_id, uint64_t clock_offset) {
     // First of all set 
     uint64_t new_mtimecmp = mtimer_get_raw_time() + clock_offset;
+#if defined(MTIMER_LATENCY_STATS)
+    if (hart_id == MTIMER_HART_ID) {
+        // Remember the compare point of this hart's timer
+        mtimer_latency.mtimecmp = new_mtimecmp;
+    }
+#endif
 #if (__riscv_xlen == 64)
     // Single bus access
-    volatile uint64_t *mtimecmp = (volatile uint64_t*)(RISCV_MTIMECMP_ADDR);
+    volatile uint64_t *mtimecmp = (volatile uint64_t*)(RISCV_MTIMECMP_HART_ADDR(hart_id));
     *mtimecmp = new_mtimecmp;
 #else
-    volatile uint32_t *mtimecmpl = (volatile uint32_t *)(RISCV_MTIMECMP_ADDR);
-    volatile uint32_t *mtimecmph = (volatile uint32_t *)(RISCV_MTIMECMP_ADDR+4);
+    volatile uint32_t *mtimecmpl = (volatile uint32_t *)(RISCV_MTIMECMP_HART_ADDR(hart_id));
+    volatile uint32_t *mtimecmph = (volatile uint32_t *)(RISCV_MTIMECMP_HART_ADDR(hart_id)+4);
     // AS we are doing 32 bit writes, an intermediate mtimecmp value may cause spurious interrupts.
     // Prevent that by first setting the dummy MSB to an unacheivable value
     *mtimecmph = 0xFFFFFFFF;  // cppcheck-suppress redundantAssignment
@@ -27,26 +41,41 @@ void mtimer_set_raw_time_cmp(uint64_t clock_offset) {
     *mtimecmph = (uint32_t)(new_mtimecmp >> 32); // cppcheck-suppress redundantAssignment
 #endif
 }
- 
-/** Read the raw time of the system timer in system timer clocks
- */
-uint64_t mtimer_get_raw_time(void) {
-#if ( __riscv_xlen == 64)
-    // Directly read 64 bit value
-    volatile uint64_t *mtime = (volatile uint64_t *)(RISCV_MTIME_ADDR);
-    return *mtime;
+
+void stimer_set_raw_time_cmp(uint64_t clock_offset) {
+    uint64_t new_stimecmp = mtimer_get_raw_time_csr() + clock_offset;
+#if (__riscv_xlen == 64)
+    csr_write_stimecmp(new_stimecmp);
 #else
-    volatile uint32_t * mtimel = (volatile uint32_t *)(RISCV_MTIME_ADDR);
-    volatile uint32_t * mtimeh = (volatile uint32_t *)(RISCV_MTIME_ADDR+4);
-    uint32_t mtimeh_val;
-    uint32_t mtimel_val;
-    do {
-        // There is a small risk the mtimeh will tick over after reading mtimel
-        mtimeh_val = *mtimeh;
-        mtimel_val = *mtimel;
-        // Poll mtimeh to ensure it's consistent after reading mtimel
-        // The frequency of mtimeh ticking over is low
-    } while (mtimeh_val != *mtimeh);
-    return (uint64_t) ( ( ((uint64_t)mtimeh_val)<<32) | mtimel_val);
+    // As with mtimecmp, prevent a spurious interrupt from an intermediate value
+    // by first setting the MSB to an unacheivable value
+    csr_write_stimecmph(0xFFFFFFFF);
+    csr_write_stimecmp((uint32_t)(new_stimecmp & 0x0FFFFFFFFUL));
+    csr_write_stimecmph((uint32_t)(new_stimecmp >> 32));
+#endif
+}
+
+#if defined(MTIMER_LATENCY_STATS)
+void mtimer_record_latency(void) {
+    // Sample as early as possible
+    uint64_t entry_time = mtimer_get_raw_time();
+
+    uint64_t late_ticks = entry_time - mtimer_latency.mtimecmp;
+    uint32_t ticks = (late_ticks > UINT32_MAX) ? UINT32_MAX : (uint32_t)late_ticks;
+
+    if (mtimer_latency.count == 0) {
+        mtimer_latency.min_ticks = ticks;
+        mtimer_latency.max_ticks = ticks;
+    } else {
+        if (ticks < mtimer_latency.min_ticks) mtimer_latency.min_ticks = ticks;
+        if (ticks > mtimer_latency.max_ticks) mtimer_latency.max_ticks = ticks;
+    }
+    mtimer_latency.count++;
+
+    uint32_t bucket = ticks >> MTIMER_LATENCY_BUCKET_SHIFT;
+    if (bucket >= MTIMER_LATENCY_BUCKETS) {
+        bucket = MTIMER_LATENCY_BUCKETS - 1;
+    }
+    mtimer_latency.histogram[bucket]++;
+}
 #endif
-} 
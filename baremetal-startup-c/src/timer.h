@@ -11,9 +11,28 @@
 
 #include <stdint.h>
 
+#include "riscv-csr.h"
+
+#define RISCV_MSIP_ADDR     (0x2000000 + 0x0000)
 #define RISCV_MTIMECMP_ADDR (0x2000000 + 0x4000)
 #define RISCV_MTIME_ADDR    (0x2000000 + 0xBFF8)
 
+// Per-hart register stride of the standard CLINT layout
+#define RISCV_MSIP_STRIDE     4
+#define RISCV_MTIMECMP_STRIDE 8
+
+#define RISCV_MSIP_HART_ADDR(HART_ID)           \
+    (RISCV_MSIP_ADDR + ((HART_ID)*RISCV_MSIP_STRIDE))
+
+#define RISCV_MTIMECMP_HART_ADDR(HART_ID)       \
+    (RISCV_MTIMECMP_ADDR + ((HART_ID)*RISCV_MTIMECMP_STRIDE))
+
+#ifndef MTIMER_HART_ID
+// Hart ID of the mtimecmp register used by mtimer_set_raw_time_cmp().
+// Define as csr_read_mhartid() to select the mtimecmp of the calling hart at runtime.
+#define MTIMER_HART_ID 0
+#endif
+
 #ifndef MTIME_FREQ_HZ
 // Timer for HiFive board
 #define MTIME_FREQ_HZ 32768
@@ -36,9 +55,139 @@
  */
 void mtimer_set_raw_time_cmp(uint64_t clock_offset);
 
+/** Set the raw time compare point in system timer clocks for a given hart.
+ * @param hart_id Hart that owns the mtimecmp register.
+ * @param clock_offset Time relative to current mtime when 
+ */
+void mtimer_set_hart_raw_time_cmp(uint_xlen_t hart_id, uint64_t clock_offset);
+
+/** Read the raw time of the system timer from the memory mapped mtime register.
+ */
+static inline uint64_t mtimer_get_raw_time_mmio(void) {
+#if ( __riscv_xlen == 64)
+    // Directly read 64 bit value
+    volatile uint64_t *mtime = (volatile uint64_t *)(RISCV_MTIME_ADDR);
+    return *mtime;
+#else
+    volatile uint32_t * mtimel = (volatile uint32_t *)(RISCV_MTIME_ADDR);
+    volatile uint32_t * mtimeh = (volatile uint32_t *)(RISCV_MTIME_ADDR+4);
+    uint32_t mtimeh_val;
+    uint32_t mtimel_val;
+    do {
+        // There is a small risk the mtimeh will tick over after reading mtimel
+        mtimeh_val = *mtimeh;
+        mtimel_val = *mtimel;
+        // Poll mtimeh to ensure it's consistent after reading mtimel
+        // The frequency of mtimeh ticking over is low
+    } while (mtimeh_val != *mtimeh);
+    return (uint64_t) ( ( ((uint64_t)mtimeh_val)<<32) | mtimel_val);
+#endif
+}
+
+/** Read the raw time of the system timer from the time/timeh CSRs with rdtime.
+ * @note Reading the CSR does not need a bus access on cores that shadow mtime locally.
+ */
+static inline uint64_t mtimer_get_raw_time_csr(void) {
+#if ( __riscv_xlen == 64)
+    // Directly read 64 bit value
+    return csr_read_time();
+#else
+    uint32_t timeh_val;
+    uint32_t timel_val;
+    do {
+        // There is a small risk the timeh will tick over after reading time
+        timeh_val = csr_read_timeh();
+        timel_val = csr_read_time();
+        // Poll timeh to ensure it's consistent after reading time
+    } while (timeh_val != csr_read_timeh());
+    return (uint64_t) ( ( ((uint64_t)timeh_val)<<32) | timel_val);
+#endif
+}
+
 /** Read the raw time of the system timer in system timer clocks
+ * @note Define MTIMER_USE_RDTIME to read the time/timeh CSRs (Zicntr) instead of the 
+ * memory mapped mtime register. The core must implement the time CSR.
+ * Both backends are inline, there is no call overhead in either case.
+ */
+static inline uint64_t mtimer_get_raw_time(void) {
+#if defined(MTIMER_USE_RDTIME)
+    return mtimer_get_raw_time_csr();
+#else
+    return mtimer_get_raw_time_mmio();
+#endif
+}
+
+/** Set the supervisor timer compare point (Sstc stimecmp) in system timer clocks.
+ * @param clock_offset Time relative to the current time CSR value.
+ * @note The supervisor timer interrupt (STI) is raised directly by the stimecmp
+ * comparison, there is no M-mode MTI handler forwarding the interrupt.
+ * M-mode must set menvcfg.STCE and mcounteren.TM before S-mode calls this function.
+ */
+void stimer_set_raw_time_cmp(uint64_t clock_offset);
+
+#if defined(MTIMER_LATENCY_STATS)
+
+#ifndef MTIMER_LATENCY_BUCKETS
+// Number of histogram buckets, the last bucket counts all larger latencies.
+#define MTIMER_LATENCY_BUCKETS 16
+#endif
+
+#ifndef MTIMER_LATENCY_BUCKET_SHIFT
+// Each histogram bucket covers (1<<MTIMER_LATENCY_BUCKET_SHIFT) system timer clocks.
+#define MTIMER_LATENCY_BUCKET_SHIFT 0
+#endif
+
+/** Timer interrupt latency statistics, enabled by defining MTIMER_LATENCY_STATS.
+ * The latency is the number of system timer clocks from mtimecmp to the handler entry, (mtime - mtimecmp).
+ * Inspect with a debugger, e.g. "print mtimer_latency".
+ */
+struct mtimer_latency_stats {
+    // Compare value last programmed by mtimer_set_raw_time_cmp()
+    uint64_t mtimecmp;
+    // Number of recorded interrupts
+    uint32_t count;
+    // Latency in system timer clocks
+    uint32_t min_ticks;
+    uint32_t max_ticks;
+    // Histogram of the latency in system timer clocks
+    uint32_t histogram[MTIMER_LATENCY_BUCKETS];
+};
+
+extern volatile struct mtimer_latency_stats mtimer_latency;
+
+/** Record the latency of the current timer interrupt in mtimer_latency.
+ * @note Call at the entry of the MTI handler, before mtimecmp is re-programmed.
+ */
+void mtimer_record_latency(void);
+
+#define MTIMER_RECORD_LATENCY() mtimer_record_latency()
+
+#else
+
+#define MTIMER_RECORD_LATENCY() do { } while (0)
+
+#endif // #if defined(MTIMER_LATENCY_STATS)
+
+/** Raise the machine software interrupt (MSI) of a hart via its CLINT msip register.
+ */
+static inline void clint_set_msip(uint_xlen_t hart_id) {
+    volatile uint32_t *msip = (volatile uint32_t *)(RISCV_MSIP_HART_ADDR(hart_id));
+    *msip = 1;
+}
+
+/** Clear the machine software interrupt (MSI) of a hart via its CLINT msip register.
+ */
+static inline void clint_clr_msip(uint_xlen_t hart_id) {
+    volatile uint32_t *msip = (volatile uint32_t *)(RISCV_MSIP_HART_ADDR(hart_id));
+    *msip = 0;
+}
+
+/** Read the machine software interrupt (MSI) pending bit of a hart from its CLINT msip register.
  */
-uint64_t mtimer_get_raw_time(void);
+static inline uint32_t clint_read_msip(uint_xlen_t hart_id) {
+    volatile uint32_t *msip = (volatile uint32_t *)(RISCV_MSIP_HART_ADDR(hart_id));
+    return *msip & 0x1;
+}
             
 
 #endif // #ifdef TIMER_H
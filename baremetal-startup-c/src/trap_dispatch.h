@@ -0,0 +1,82 @@
+/*
+   Table driven trap entry for direct mode mtvec.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef TRAP_DISPATCH_H
+#define TRAP_DISPATCH_H
+
+#include "riscv-csr.h"
+
+/* In direct mode every trap enters at mtvec.BASE. The entry reads
+   mcause, selects the interrupt or exception table with the sign bit,
+   masks the cause to the table size and calls the handler. There is no
+   switch or search, every cause has the same dispatch cost.
+
+   The handlers are plain functions, the entry is an interrupt ("machine")
+   function that saves the caller saved registers and returns with mret.
+
+   Usage:
+
+   static void irq_mti(void);
+
+   TRAP_DISPATCH_INTERRUPT_TABLE(irq_interrupts) = {
+       [0 ... TRAP_DISPATCH_INTERRUPTS-1] = trap_dispatch_nop,
+       [RISCV_INT_POS_MTI] = irq_mti,
+   };
+   TRAP_DISPATCH_EXCEPTION_TABLE(irq_exceptions) = {
+       [0 ... TRAP_DISPATCH_EXCEPTIONS-1] = trap_dispatch_nop,
+   };
+   TRAP_DISPATCH_ENTRY(irq_entry, irq_interrupts, irq_exceptions)
+
+   csr_write_mtvec((uint_xlen_t) irq_entry);
+*/
+
+#ifndef TRAP_DISPATCH_INTERRUPTS
+// Size of the interrupt table, the standard local interrupts. Must be a power of 2.
+#define TRAP_DISPATCH_INTERRUPTS 16
+#endif
+
+#ifndef TRAP_DISPATCH_EXCEPTIONS
+// Size of the exception table, the standard exceptions. Must be a power of 2.
+#define TRAP_DISPATCH_EXCEPTIONS 16
+#endif
+
+#if ((TRAP_DISPATCH_INTERRUPTS & (TRAP_DISPATCH_INTERRUPTS - 1)) != 0) || ((TRAP_DISPATCH_EXCEPTIONS & (TRAP_DISPATCH_EXCEPTIONS - 1)) != 0)
+#error "TRAP_DISPATCH_INTERRUPTS and TRAP_DISPATCH_EXCEPTIONS must be a power of 2"
+#endif
+
+/** Handler called by a trap dispatch entry, a plain function. */
+typedef void (*trap_dispatch_fn_t)(void);
+
+/** Default handler, returns to mepc. */
+static inline void trap_dispatch_nop(void) {
+}
+
+/** Define a table of interrupt handlers indexed by cause */
+#define TRAP_DISPATCH_INTERRUPT_TABLE(NAME) \
+    static const trap_dispatch_fn_t NAME[TRAP_DISPATCH_INTERRUPTS]
+
+/** Define a table of exception handlers indexed by cause */
+#define TRAP_DISPATCH_EXCEPTION_TABLE(NAME) \
+    static const trap_dispatch_fn_t NAME[TRAP_DISPATCH_EXCEPTIONS]
+
+/** Define a direct mode trap entry NAME that dispatches to the INTERRUPTS or EXCEPTIONS table.
+    A cause outside the table is masked to a cause within the table.
+ */
+#define TRAP_DISPATCH_ENTRY(NAME, INTERRUPTS, EXCEPTIONS)                           \
+    void NAME(void) __attribute__ ((interrupt ("machine"), aligned(4)));            \
+    void NAME(void) {                                                               \
+        uint_xlen_t cause = csr_read_mcause();                                      \
+        /* mcause.Interrupt is the sign bit, tested with bltz */                    \
+        if (cause & MCAUSE_INTERRUPT_BIT_MASK) {                                    \
+            (INTERRUPTS)[cause & (TRAP_DISPATCH_INTERRUPTS - 1)]();                 \
+        } else {                                                                    \
+            (EXCEPTIONS)[cause & (TRAP_DISPATCH_EXCEPTIONS - 1)]();                 \
+        }                                                                           \
+    }
+
+#endif // #ifdef TRAP_DISPATCH_H
@@ -0,0 +1,96 @@
+/*
+   RAII guards to disable interrupts for a scope.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef CRITICAL_SECTION_HPP
+#define CRITICAL_SECTION_HPP
+
+#include "riscv-csr.hpp"
+
+namespace riscv {
+
+    /** Disable machine mode interrupts for the lifetime of the guard.
+
+        The constructor clears mstatus.MIE and saves the previous value with a single csrrci.
+        The destructor sets mstatus.MIE again only if it was set before, so critical sections
+        can be nested and can be used where interrupts are already disabled.
+
+        Usage:
+            {
+                riscv::critical_section guard;
+                // Interrupts disabled
+            }
+            // Interrupts restored to the previous state
+     */
+    class critical_section {
+    public:
+        critical_section(void)
+            : mstatus_(riscv::csr::mstatus_ops::read_clr_bits_imm(MIE_MASK)) {
+            // Accesses in the critical section must not be moved before this point
+            barrier();
+        }
+        ~critical_section() {
+            barrier();
+            // csrs with 0 is a no-op when MIE was clear on entry
+            riscv::csr::mstatus_ops::set_bits(mstatus_ & MIE_MASK);
+        }
+        critical_section(const critical_section&) = delete;
+        critical_section& operator=(const critical_section&) = delete;
+
+    private:
+        static constexpr riscv::csr::uint_xlen_t MIE_MASK = riscv::csr::mstatus_data::mie::BIT_MASK;
+        static_assert((MIE_MASK & riscv::csr::CSR_IMM_OP_MASK) == MIE_MASK, "mstatus.MIE must fit a CSR immediate");
+
+        static inline void barrier(void) {
+            __asm__ volatile ("" : : : "memory");
+        }
+
+        const riscv::csr::uint_xlen_t mstatus_;
+    };
+
+    /** Mask selected interrupt sources in mie for the lifetime of the guard.
+        Interrupts from other sources are still taken, unlike riscv::critical_section.
+
+        The previous state of the masked bits is saved and restored, so guards can be nested.
+
+        Usage:
+            {
+                riscv::mask_guard<riscv::csr::mie_data::mti> guard;
+                // Timer interrupt masked
+            }
+
+        @tparam SOURCES mie fields, e.g. riscv::csr::mie_data::mti.
+     */
+    template<class... SOURCES>
+    class mask_guard {
+    public:
+        static constexpr riscv::csr::uint_xlen_t MASK = (SOURCES::BIT_MASK | ...);
+
+        mask_guard(void)
+            : mie_(riscv::csrs.mie.read_clr_bits_const<MASK>()) {
+            barrier();
+        }
+        ~mask_guard() {
+            barrier();
+            riscv::csr::mie_ops::set_bits(mie_ & MASK);
+        }
+        mask_guard(const mask_guard&) = delete;
+        mask_guard& operator=(const mask_guard&) = delete;
+
+    private:
+        static_assert(sizeof...(SOURCES) > 0, "mask_guard needs at least one interrupt source");
+
+        static inline void barrier(void) {
+            __asm__ volatile ("" : : : "memory");
+        }
+
+        const riscv::csr::uint_xlen_t mie_;
+    };
+
+} /* riscv */
+
+#endif // #ifdef CRITICAL_SECTION_HPP
@@ -0,0 +1,109 @@
+/*
+   Calibrated busy-wait delays using the mcycle counter.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef DELAY_HPP
+#define DELAY_HPP
+
+#include <cstdint>
+#include <chrono>
+
+#include "riscv-csr.hpp"
+#include "timer.hpp"
+
+namespace riscv {
+
+    /** Core clock calibration for the delay functions.
+        The conversion factors are fixed point, calculated once by delay_calibrate().
+     */
+    struct delay_calibration {
+        /** Fraction bits of cycles_per_us */
+        static constexpr unsigned int US_FRAC_BITS = 16;
+        /** Fraction bits of cycles_per_ns */
+        static constexpr unsigned int NS_FRAC_BITS = 28;
+        /** Measured core clock frequency */
+        static inline std::uint64_t core_freq_hz{0};
+        /** Core clock cycles per micro-second, fixed point with US_FRAC_BITS fraction bits */
+        static inline std::uint32_t cycles_per_us{0};
+        /** Core clock cycles per nano-second, fixed point with NS_FRAC_BITS fraction bits */
+        static inline std::uint32_t cycles_per_ns{0};
+    };
+
+    /** Busy wait for a number of core clock cycles.
+        @note The delay must be less than 2^XLEN cycles.
+     */
+    static inline void delay_cycles(riscv::csr::uint_xlen_t cycles) {
+        riscv::csr::uint_xlen_t start = riscv::csrs.mcycle.read();
+        // Unsigned subtraction handles a wrap around of mcycle
+        while ((static_cast<riscv::csr::uint_xlen_t>(riscv::csrs.mcycle.read()) - start) < cycles) {
+        }
+    }
+
+    /** Busy wait for a number of nano-seconds.
+        @note delay_calibrate() must be called first, until then there is no delay.
+        @note The delay must be less than 2^XLEN core clock cycles, use delay() for longer delays.
+     */
+    static inline void delay_ns(std::uint32_t ns) {
+        delay_cycles((static_cast<std::uint64_t>(ns) * delay_calibration::cycles_per_ns) >> delay_calibration::NS_FRAC_BITS);
+    }
+
+    /** Busy wait for a number of micro-seconds.
+        @note delay_calibrate() must be called first, until then there is no delay.
+        @note The delay must be less than 2^XLEN core clock cycles, use delay() for longer delays.
+     */
+    static inline void delay_us(std::uint32_t us) {
+        delay_cycles((static_cast<std::uint64_t>(us) * delay_calibration::cycles_per_us) >> delay_calibration::US_FRAC_BITS);
+    }
+
+    /** Longest delay_ns() call made by delay(), 2^32 cycles is 4.29 seconds at 1GHz */
+    static constexpr std::chrono::nanoseconds DELAY_CHUNK = std::chrono::seconds{1};
+
+    /** Busy wait for a std::chrono::duration.
+        Delays longer than DELAY_CHUNK are split into DELAY_CHUNK calls of delay_ns(),
+        so neither the 32 bit nano-second argument nor the XLEN bit cycle count wraps.
+        A negative duration is no delay.
+     */
+    template<class REP, class PERIOD> static inline void delay(std::chrono::duration<REP, PERIOD> time) {
+        auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(time);
+        while (remaining > DELAY_CHUNK) {
+            delay_ns(DELAY_CHUNK.count());
+            remaining -= DELAY_CHUNK;
+        }
+        if (remaining.count() > 0) {
+            delay_ns(static_cast<std::uint32_t>(remaining.count()));
+        }
+    }
+
+    /** Measure the core clocks per system timer tick, and calculate the delay conversion factors.
+        Run once at boot, with interrupts disabled.
+        @tparam CALIBRATION_TICKS Number of system timer ticks to measure over. Longer is more accurate.
+     */
+    template<class CONFIG=driver::default_timer_config,
+             class TIMER=driver::timer<std::chrono::microseconds, driver::mtimer_address_spec, CONFIG>,
+             std::uint32_t CALIBRATION_TICKS=32>
+    static void delay_calibrate(void) {
+        TIMER timer;
+        // Align the start to a system timer tick
+        auto prev_tick = timer.get_raw_time();
+        auto start_tick = prev_tick;
+        while ((start_tick = timer.get_raw_time()) == prev_tick) {
+        }
+        riscv::csr::uint_xlen_t start_cycle = riscv::csrs.mcycle.read();
+        while ((timer.get_raw_time() - start_tick) < CALIBRATION_TICKS) {
+        }
+        riscv::csr::uint_xlen_t cycles = static_cast<riscv::csr::uint_xlen_t>(riscv::csrs.mcycle.read()) - start_cycle;
+
+        // core_freq = cycles/tick * ticks/second
+        auto core_freq_hz = (static_cast<std::uint64_t>(cycles) * CONFIG::MTIME_FREQ_HZ) / CALIBRATION_TICKS;
+        delay_calibration::core_freq_hz = core_freq_hz;
+        delay_calibration::cycles_per_us = (core_freq_hz << delay_calibration::US_FRAC_BITS) / 1000000ULL;
+        delay_calibration::cycles_per_ns = (core_freq_hz << delay_calibration::NS_FRAC_BITS) / 1000000000ULL;
+    }
+
+} /* riscv */
+
+#endif // #ifdef DELAY_HPP
@@ -0,0 +1,266 @@
+/*
+   Floating point context aware trap entry, using mstatus.FS.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef FPU_CONTEXT_HPP
+#define FPU_CONTEXT_HPP
+
+#include <cstdint>
+
+#include "riscv-csr.hpp"
+
+#if (__riscv_xlen == 64)
+#define RISCV_FPU_CONTEXT_STORE    "sd"
+#define RISCV_FPU_CONTEXT_LOAD     "ld"
+#define RISCV_FPU_CONTEXT_REGBYTES "8"
+#else
+#define RISCV_FPU_CONTEXT_STORE    "sw"
+#define RISCV_FPU_CONTEXT_LOAD     "lw"
+#define RISCV_FPU_CONTEXT_REGBYTES "4"
+#endif
+#if defined(__riscv_flen) && (__riscv_flen == 64)
+#define RISCV_FPU_CONTEXT_FSTORE    "fsd"
+#define RISCV_FPU_CONTEXT_FLOAD     "fld"
+#define RISCV_FPU_CONTEXT_FLENBYTES "8"
+#else
+#define RISCV_FPU_CONTEXT_FSTORE    "fsw"
+#define RISCV_FPU_CONTEXT_FLOAD     "flw"
+#define RISCV_FPU_CONTEXT_FLENBYTES "4"
+#endif
+// 20 integer registers keeps the stack 16 byte aligned for RV32 and RV64.
+// 16 caller saved registers, mstatus at 16.
+#define RISCV_FPU_CONTEXT_FRAME    "20*" RISCV_FPU_CONTEXT_REGBYTES
+// 20 caller saved FP registers after the integer registers, fcsr after the FP registers, 16 byte aligned.
+#define RISCV_FPU_CONTEXT_FP_FRAME RISCV_FPU_CONTEXT_FRAME "+20*" RISCV_FPU_CONTEXT_FLENBYTES "+16"
+#define RISCV_FPU_CONTEXT_FCSR     RISCV_FPU_CONTEXT_FRAME "+20*" RISCV_FPU_CONTEXT_FLENBYTES
+#define RISCV_FPU_CONTEXT_SAVE(REG, N)     RISCV_FPU_CONTEXT_STORE " " #REG ", " #N "*" RISCV_FPU_CONTEXT_REGBYTES "(sp);"
+#define RISCV_FPU_CONTEXT_RESTORE(REG, N)  RISCV_FPU_CONTEXT_LOAD  " " #REG ", " #N "*" RISCV_FPU_CONTEXT_REGBYTES "(sp);"
+#define RISCV_FPU_CONTEXT_FSAVE(REG, N)    RISCV_FPU_CONTEXT_FSTORE " " #REG ", " RISCV_FPU_CONTEXT_FRAME "+" #N "*" RISCV_FPU_CONTEXT_FLENBYTES "(sp);"
+#define RISCV_FPU_CONTEXT_FRESTORE(REG, N) RISCV_FPU_CONTEXT_FLOAD  " " #REG ", " RISCV_FPU_CONTEXT_FRAME "+" #N "*" RISCV_FPU_CONTEXT_FLENBYTES "(sp);"
+#define RISCV_FPU_CONTEXT_STR_(X) #X
+#define RISCV_FPU_CONTEXT_STR(X) RISCV_FPU_CONTEXT_STR_(X)
+// Shift mstatus left to move FS[1] to the sign bit. FS[1] is set when FS is Clean or Dirty.
+#define RISCV_FPU_CONTEXT_FS_LIVE_SHIFT RISCV_FPU_CONTEXT_STR(__riscv_xlen-14-1)
+
+#define RISCV_FPU_CONTEXT_SAVE_INT                  \
+    RISCV_FPU_CONTEXT_SAVE(ra, 0)                   \
+    RISCV_FPU_CONTEXT_SAVE(t0, 1)                   \
+    RISCV_FPU_CONTEXT_SAVE(t1, 2)                   \
+    RISCV_FPU_CONTEXT_SAVE(t2, 3)                   \
+    RISCV_FPU_CONTEXT_SAVE(t3, 4)                   \
+    RISCV_FPU_CONTEXT_SAVE(t4, 5)                   \
+    RISCV_FPU_CONTEXT_SAVE(t5, 6)                   \
+    RISCV_FPU_CONTEXT_SAVE(t6, 7)                   \
+    RISCV_FPU_CONTEXT_SAVE(a0, 8)                   \
+    RISCV_FPU_CONTEXT_SAVE(a1, 9)                   \
+    RISCV_FPU_CONTEXT_SAVE(a2, 10)                  \
+    RISCV_FPU_CONTEXT_SAVE(a3, 11)                  \
+    RISCV_FPU_CONTEXT_SAVE(a4, 12)                  \
+    RISCV_FPU_CONTEXT_SAVE(a5, 13)                  \
+    RISCV_FPU_CONTEXT_SAVE(a6, 14)                  \
+    RISCV_FPU_CONTEXT_SAVE(a7, 15)
+
+#define RISCV_FPU_CONTEXT_RESTORE_INT               \
+    RISCV_FPU_CONTEXT_RESTORE(ra, 0)                \
+    RISCV_FPU_CONTEXT_RESTORE(t0, 1)                \
+    RISCV_FPU_CONTEXT_RESTORE(t1, 2)                \
+    RISCV_FPU_CONTEXT_RESTORE(t2, 3)                \
+    RISCV_FPU_CONTEXT_RESTORE(t3, 4)                \
+    RISCV_FPU_CONTEXT_RESTORE(t4, 5)                \
+    RISCV_FPU_CONTEXT_RESTORE(t5, 6)                \
+    RISCV_FPU_CONTEXT_RESTORE(t6, 7)                \
+    RISCV_FPU_CONTEXT_RESTORE(a0, 8)                \
+    RISCV_FPU_CONTEXT_RESTORE(a1, 9)                \
+    RISCV_FPU_CONTEXT_RESTORE(a2, 10)               \
+    RISCV_FPU_CONTEXT_RESTORE(a3, 11)               \
+    RISCV_FPU_CONTEXT_RESTORE(a4, 12)               \
+    RISCV_FPU_CONTEXT_RESTORE(a5, 13)               \
+    RISCV_FPU_CONTEXT_RESTORE(a6, 14)               \
+    RISCV_FPU_CONTEXT_RESTORE(a7, 15)
+
+namespace riscv {
+
+    /** Trap entries that handle the floating point state lazily with mstatus.FS.
+
+        An interrupt ("machine") function on an F or D target saves the FP
+        registers whenever the handler might use them. These entries save
+        only the integer caller saved registers and mstatus, the handlers
+        are plain functions.
+
+        - entry<HANDLER>    : FS is set to Off while HANDLER runs. The FP
+                              registers are not saved, any FP instruction in
+                              HANDLER traps as an illegal instruction.
+        - entry_fp<HANDLER> : The caller saved FP registers and fcsr are saved
+                              only if the interrupted code has live FP state,
+                              FS is Dirty (or Clean). HANDLER runs with the FPU
+                              enabled.
+
+        Both restore mstatus.FS of the interrupted code before mret.
+
+        Usage:
+            static void mti_handler(void);  // Plain function, no FP
+            static void msi_handler(void);  // Plain function, uses FP
+            riscv::fpu_context::init();
+            using table = riscv::mtvec_table<default_handler,
+                                             riscv::vector<riscv::interrupts::mti, riscv::fpu_context::entry<mti_handler>>,
+                                             riscv::vector<riscv::interrupts::msi, riscv::fpu_context::entry_fp<msi_handler>>>;
+     */
+    struct fpu_context {
+        /** Value of mstatus.FS */
+        enum fs_state : std::uint32_t {
+            OFF = 0,
+            INITIAL = 1,
+            CLEAN = 2,
+            DIRTY = 3,
+        };
+
+        /** Enable the FPU for the main program, FS = Initial and fcsr = 0.
+            Call before any FP instruction, FS is Off after reset.
+         */
+        static void init(void) {
+#if defined(__riscv_flen)
+            riscv::csrs.mstatus.write((riscv::csrs.mstatus.read() & ~riscv::csr::mstatus_data::fs::BIT_MASK)
+                                      | (INITIAL << riscv::csr::mstatus_data::fs::BIT_OFFSET));
+            __asm__ volatile ("fscsr zero");
+#endif
+        }
+
+        /** FS of the current context */
+        static fs_state state(void) {
+            return static_cast<fs_state>(riscv::csrs.mstatus.fs.read());
+        }
+
+        /** Trap entry that runs the plain function HANDLER with the FPU Off.
+            Use as the direct mode mtvec, or as the target of a vector table entry.
+         */
+        template<void (*HANDLER)(void)>
+        static void entry(void) __attribute__ ((naked, aligned(4)));
+
+#if defined(__riscv_flen)
+        /** Trap entry that runs the plain function HANDLER with the FPU enabled.
+            The caller saved FP registers and fcsr are only saved if FS is Clean or Dirty.
+            Use as the direct mode mtvec, or as the target of a vector table entry.
+         */
+        template<void (*HANDLER)(void)>
+        static void entry_fp(void) __attribute__ ((naked, aligned(4)));
+#endif
+    };
+
+    template<void (*HANDLER)(void)>
+    void fpu_context::entry(void) {
+        __asm__ volatile (
+            "addi  sp, sp, -" RISCV_FPU_CONTEXT_FRAME ";"
+            RISCV_FPU_CONTEXT_SAVE_INT
+            "csrr  t0, mstatus;"
+            RISCV_FPU_CONTEXT_SAVE(t0, 16)
+            // FS = Off
+            "li    t1, %1;"
+            "csrc  mstatus, t1;"
+            "call  %0;"
+            // Restore FS of the interrupted code
+            "li    t1, %1;"
+            RISCV_FPU_CONTEXT_RESTORE(t0, 16)
+            "and   t0, t0, t1;"
+            "csrc  mstatus, t1;"
+            "csrs  mstatus, t0;"
+            RISCV_FPU_CONTEXT_RESTORE_INT
+            "addi  sp, sp, " RISCV_FPU_CONTEXT_FRAME ";"
+            "mret;"
+            : /* output: none */
+            : /* input : immediate */ "i"(HANDLER), "i"(riscv::csr::mstatus_data::fs::BIT_MASK)
+            : /* clobbers: none */
+            );
+    }
+
+#if defined(__riscv_flen)
+    template<void (*HANDLER)(void)>
+    void fpu_context::entry_fp(void) {
+        __asm__ volatile (
+            "addi  sp, sp, -(" RISCV_FPU_CONTEXT_FP_FRAME ");"
+            RISCV_FPU_CONTEXT_SAVE_INT
+            "csrr  t0, mstatus;"
+            RISCV_FPU_CONTEXT_SAVE(t0, 16)
+            // FS is Off or Initial, no live FP state
+            "slli  t1, t0, " RISCV_FPU_CONTEXT_FS_LIVE_SHIFT ";"
+            "bgez  t1, 1f;"
+            RISCV_FPU_CONTEXT_FSAVE(ft0, 0)
+            RISCV_FPU_CONTEXT_FSAVE(ft1, 1)
+            RISCV_FPU_CONTEXT_FSAVE(ft2, 2)
+            RISCV_FPU_CONTEXT_FSAVE(ft3, 3)
+            RISCV_FPU_CONTEXT_FSAVE(ft4, 4)
+            RISCV_FPU_CONTEXT_FSAVE(ft5, 5)
+            RISCV_FPU_CONTEXT_FSAVE(ft6, 6)
+            RISCV_FPU_CONTEXT_FSAVE(ft7, 7)
+            RISCV_FPU_CONTEXT_FSAVE(ft8, 8)
+            RISCV_FPU_CONTEXT_FSAVE(ft9, 9)
+            RISCV_FPU_CONTEXT_FSAVE(ft10, 10)
+            RISCV_FPU_CONTEXT_FSAVE(ft11, 11)
+            RISCV_FPU_CONTEXT_FSAVE(fa0, 12)
+            RISCV_FPU_CONTEXT_FSAVE(fa1, 13)
+            RISCV_FPU_CONTEXT_FSAVE(fa2, 14)
+            RISCV_FPU_CONTEXT_FSAVE(fa3, 15)
+            RISCV_FPU_CONTEXT_FSAVE(fa4, 16)
+            RISCV_FPU_CONTEXT_FSAVE(fa5, 17)
+            RISCV_FPU_CONTEXT_FSAVE(fa6, 18)
+            RISCV_FPU_CONTEXT_FSAVE(fa7, 19)
+            "frcsr t1;"
+            RISCV_FPU_CONTEXT_STORE " t1, " RISCV_FPU_CONTEXT_FCSR "(sp);"
+            "1:"
+            // Enable the FPU for the handler, FS = Initial when Off
+            "li    t1, %2;"
+            "csrs  mstatus, t1;"
+            "call  %0;"
+            RISCV_FPU_CONTEXT_RESTORE(t0, 16)
+            "slli  t1, t0, " RISCV_FPU_CONTEXT_FS_LIVE_SHIFT ";"
+            "bgez  t1, 2f;"
+            RISCV_FPU_CONTEXT_FRESTORE(ft0, 0)
+            RISCV_FPU_CONTEXT_FRESTORE(ft1, 1)
+            RISCV_FPU_CONTEXT_FRESTORE(ft2, 2)
+            RISCV_FPU_CONTEXT_FRESTORE(ft3, 3)
+            RISCV_FPU_CONTEXT_FRESTORE(ft4, 4)
+            RISCV_FPU_CONTEXT_FRESTORE(ft5, 5)
+            RISCV_FPU_CONTEXT_FRESTORE(ft6, 6)
+            RISCV_FPU_CONTEXT_FRESTORE(ft7, 7)
+            RISCV_FPU_CONTEXT_FRESTORE(ft8, 8)
+            RISCV_FPU_CONTEXT_FRESTORE(ft9, 9)
+            RISCV_FPU_CONTEXT_FRESTORE(ft10, 10)
+            RISCV_FPU_CONTEXT_FRESTORE(ft11, 11)
+            RISCV_FPU_CONTEXT_FRESTORE(fa0, 12)
+            RISCV_FPU_CONTEXT_FRESTORE(fa1, 13)
+            RISCV_FPU_CONTEXT_FRESTORE(fa2, 14)
+            RISCV_FPU_CONTEXT_FRESTORE(fa3, 15)
+            RISCV_FPU_CONTEXT_FRESTORE(fa4, 16)
+            RISCV_FPU_CONTEXT_FRESTORE(fa5, 17)
+            RISCV_FPU_CONTEXT_FRESTORE(fa6, 18)
+            RISCV_FPU_CONTEXT_FRESTORE(fa7, 19)
+            RISCV_FPU_CONTEXT_LOAD " t1, " RISCV_FPU_CONTEXT_FCSR "(sp);"
+            "fscsr t1;"
+            "j     3f;"
+            "2:"
+            // No live FP state, drop the flags and rounding mode set by the handler
+            "fscsr zero;"
+            "3:"
+            // Restore FS of the interrupted code
+            "li    t1, %1;"
+            "and   t0, t0, t1;"
+            "csrc  mstatus, t1;"
+            "csrs  mstatus, t0;"
+            RISCV_FPU_CONTEXT_RESTORE_INT
+            "addi  sp, sp, " RISCV_FPU_CONTEXT_FP_FRAME ";"
+            "mret;"
+            : /* output: none */
+            : /* input : immediate */ "i"(HANDLER),
+              "i"(riscv::csr::mstatus_data::fs::BIT_MASK),
+              "i"(fpu_context::INITIAL << riscv::csr::mstatus_data::fs::BIT_OFFSET)
+            : /* clobbers: none */
+            );
+    }
+#endif
+
+} /* riscv */
+
+#endif // #ifdef FPU_CONTEXT_HPP
@@ -0,0 +1,139 @@
+/*
+   Interrupt coalescing with adaptive switching between interrupt and polled mode.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef IRQ_COALESCE_HPP
+#define IRQ_COALESCE_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#include "riscv-csr.hpp"
+
+namespace riscv {
+
+    /** Default limits of riscv::irq_coalesce.
+     */
+    struct default_coalesce_config {
+        /** Maximum events handled per interrupt entry or per poll */
+        static constexpr std::uint32_t BUDGET_EVENTS = 16;
+        /** Maximum mcycle clocks spent per interrupt entry or per poll */
+        static constexpr std::uint32_t BUDGET_CYCLES = 4096;
+        /** Switch to polled mode when more events than this are handled in one timer tick */
+        static constexpr std::uint32_t POLL_ENTER_EVENTS = 32;
+        /** Switch back to interrupt mode when fewer events than this are handled by a poll */
+        static constexpr std::uint32_t POLL_EXIT_EVENTS = 4;
+    };
+
+    /** Coalesce the events of a high rate interrupt source (NAPI style).
+
+        In interrupt mode the handler calls irq(). Each entry services up to BUDGET_EVENTS
+        events, or until BUDGET_CYCLES have passed, so several events share one trap entry.
+
+        The timer handler calls tick() periodically. If the budget of an interrupt entry was
+        exhausted, or more than POLL_ENTER_EVENTS were handled since the last tick, the source
+        is masked in mie and the events are serviced by tick() instead. When a poll handles
+        fewer than POLL_EXIT_EVENTS the source is unmasked and interrupt mode resumes.
+        A level triggered source that is still pending is taken again as soon as it is unmasked.
+
+        Usage:
+            // Service one event, return false when none is pending.
+            static bool rx_packet(void);
+            using rx_coalesce = riscv::irq_coalesce<rx_packet>;
+
+            static void mei_handler(void) { rx_coalesce::irq(); }
+            static void mti_handler(void) { ...; rx_coalesce::tick(); }
+
+        @tparam SERVICE Handle one event, return false if no event was pending.
+        @tparam SOURCE mie field of the interrupt source, e.g. riscv::csr::mie_data::mei
+        @tparam CONFIG Budget and thresholds, see default_coalesce_config.
+     */
+    template<bool (*SERVICE)(void),
+             class SOURCE=riscv::csr::mie_data::mei,
+             class CONFIG=default_coalesce_config>
+    class irq_coalesce {
+    public:
+        static_assert(CONFIG::POLL_EXIT_EVENTS <= CONFIG::BUDGET_EVENTS, "POLL_EXIT_EVENTS must not exceed BUDGET_EVENTS");
+
+        // Statistics, inspect with a debugger
+        /** true while the source is masked and serviced by tick() */
+        static inline volatile bool polled{false};
+        /** Interrupt entries */
+        static inline volatile std::uint32_t irq_count{0};
+        /** Polls by tick() */
+        static inline volatile std::uint32_t poll_count{0};
+        /** Total events serviced */
+        static inline volatile std::uint32_t event_count{0};
+        /** Switches from interrupt to polled mode */
+        static inline volatile std::uint32_t poll_enter_count{0};
+
+        /** Call from the interrupt handler of SOURCE. */
+        static void irq(void) {
+            irq_count = irq_count + 1;
+            std::uint32_t events = service();
+            window_events = window_events + events;
+            if (events >= CONFIG::BUDGET_EVENTS || budget_exhausted) {
+                // Still busy, stop taking interrupts
+                enter_polled();
+            }
+        }
+
+        /** Call from a periodic timer handler. */
+        static void tick(void) {
+            if (polled) {
+                poll_count = poll_count + 1;
+                std::uint32_t events = service();
+                if ((events < CONFIG::POLL_EXIT_EVENTS) && !budget_exhausted) {
+                    // Load has fallen
+                    exit_polled();
+                }
+            } else if (window_events > CONFIG::POLL_ENTER_EVENTS) {
+                enter_polled();
+            }
+            window_events = 0;
+        }
+
+    private:
+        /** Events handled in interrupt mode since the last tick() */
+        static inline std::uint32_t window_events{0};
+        /** The last service() stopped on the cycle budget */
+        static inline bool budget_exhausted{false};
+
+        // Service events until none is pending or the budget is used.
+        static std::uint32_t service(void) {
+            riscv::csr::uint_xlen_t start = riscv::csrs.mcycle.read();
+            std::uint32_t events = 0;
+            budget_exhausted = false;
+            while (events < CONFIG::BUDGET_EVENTS) {
+                if (!SERVICE()) {
+                    break;
+                }
+                events++;
+                if ((static_cast<riscv::csr::uint_xlen_t>(riscv::csrs.mcycle.read()) - start) >= CONFIG::BUDGET_CYCLES) {
+                    budget_exhausted = true;
+                    break;
+                }
+            }
+            event_count = event_count + events;
+            return events;
+        }
+        static void enter_polled(void) {
+            riscv::csr::read_write_field<riscv::csr::mie_ops, SOURCE> source;
+            source.clr();
+            polled = true;
+            poll_enter_count = poll_enter_count + 1;
+        }
+        static void exit_polled(void) {
+            riscv::csr::read_write_field<riscv::csr::mie_ops, SOURCE> source;
+            polled = false;
+            source.set();
+        }
+    };
+
+} /* riscv */
+
+#endif // #ifdef IRQ_COALESCE_HPP
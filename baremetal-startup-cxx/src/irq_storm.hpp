@@ -0,0 +1,130 @@
+/*
+   Interrupt storm detection, per cause rate limit with a sliding window.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef IRQ_STORM_HPP
+#define IRQ_STORM_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#include "riscv-csr.hpp"
+#include "critical_section.hpp"
+
+namespace riscv {
+
+    /** Default limits of riscv::irq_storm.
+     */
+    struct default_storm_config {
+        /** Maximum interrupts of one cause per window */
+        static constexpr std::uint32_t LIMIT = 64;
+        /** Window of 2^WINDOW_SHIFT mtime clocks, 1 second at 32768Hz, 3.3ms at 10MHz */
+        static constexpr unsigned int WINDOW_SHIFT = 15;
+    };
+
+    /** Count the interrupts of each cause in a sliding window of mtime.
+        When a cause has more than CONFIG::LIMIT interrupts in the window its mie bit is cleared
+        and the event is recorded, a misconfigured timer or a stuck interrupt line then no
+        longer starves the main program.
+
+        The count of the previous window is weighted by how much of it still overlaps the sliding window.
+
+        Usage:
+            using storm = riscv::irq_storm<>;
+            // In the interrupt handler, before handling 'cause'
+            if (!storm::account(cause, mtimer.get_raw_time())) {
+                return; // Masked
+            }
+            // In main, enable again
+            storm::reset(riscv::interrupts::mti);
+
+        @tparam CONFIG Limit and window, see default_storm_config.
+     */
+    template<class CONFIG=default_storm_config>
+    struct irq_storm {
+        /** Number of causes, one per bit of mie */
+        static constexpr std::size_t CAUSES = __riscv_xlen;
+        static constexpr std::uint32_t WINDOW = static_cast<std::uint32_t>(1) << CONFIG::WINDOW_SHIFT;
+
+        static_assert(CONFIG::WINDOW_SHIFT <= 24, "WINDOW_SHIFT must be less than 25");
+        static_assert(CONFIG::LIMIT < 0xFFFF, "LIMIT must be less than 0xFFFF");
+
+        // Diagnostics, inspect with a debugger
+        /** Bit set for each cause masked by the storm detection */
+        static inline volatile riscv::csr::uint_xlen_t masked{0};
+        /** Number of storms detected */
+        static inline volatile std::uint32_t storms{0};
+        /** The last storm detected */
+        static inline volatile std::uint32_t last_cause{0};
+        static inline volatile std::uint32_t last_mtime{0};
+        static inline volatile riscv::csr::uint_xlen_t last_mepc{0};
+
+        /** Count an interrupt of 'cause' at time 'now'.
+            @return false if the rate is over the limit, the cause has been masked and should not be handled.
+                    A cause outside mie is not counted and returns true.
+         */
+        static bool account(std::uint32_t cause, std::uint64_t now) {
+            if (cause >= CAUSES) {
+                return true;
+            }
+            // Only the low word is needed, the differences are wrap around safe
+            std::uint32_t now_low = static_cast<std::uint32_t>(now);
+            std::uint32_t elapsed = now_low - window_start[cause];
+            std::uint32_t count = counts[cause];
+            std::uint32_t prev = prev_counts[cause];
+            if (elapsed >= WINDOW) {
+                // Start a new window. Drop the previous window if it no longer overlaps.
+                if (elapsed < 2*WINDOW) {
+                    prev = count;
+                    elapsed -= WINDOW;
+                } else {
+                    prev = 0;
+                    elapsed = 0;
+                }
+                count = 0;
+                window_start[cause] = now_low - elapsed;
+                prev_counts[cause] = prev;
+            }
+            count++;
+            counts[cause] = count;
+            // Events in the window ending now, the previous window weighted by its overlap
+            std::uint32_t estimate = count + static_cast<std::uint32_t>((static_cast<std::uint64_t>(prev) * (WINDOW - elapsed)) >> CONFIG::WINDOW_SHIFT);
+            if (estimate <= CONFIG::LIMIT) {
+                return true;
+            }
+            riscv::csrs.mie.clr(static_cast<riscv::csr::uint_xlen_t>(1) << cause);
+            masked = masked | (static_cast<riscv::csr::uint_xlen_t>(1) << cause);
+            storms = storms + 1;
+            last_cause = cause;
+            last_mtime = now_low;
+            last_mepc = riscv::csrs.mepc.read();
+            return false;
+        }
+
+        /** Clear the storm state of a cause and set its mie bit again. */
+        static void reset(std::uint32_t cause) {
+            if (cause >= CAUSES) {
+                return;
+            }
+            // account() updates the same state
+            riscv::critical_section guard;
+            counts[cause] = 0;
+            prev_counts[cause] = 0;
+            masked = masked & ~(static_cast<riscv::csr::uint_xlen_t>(1) << cause);
+            riscv::csrs.mie.set(static_cast<riscv::csr::uint_xlen_t>(1) << cause);
+        }
+
+    private:
+        /** Per cause window, start time in mtime clocks and counts of the current and previous window */
+        static inline std::uint32_t window_start[CAUSES]{};
+        static inline std::uint16_t counts[CAUSES]{};
+        static inline std::uint16_t prev_counts[CAUSES]{};
+    };
+
+} /* riscv */
+
+#endif // #ifdef IRQ_STORM_HPP
@@ -0,0 +1,179 @@
+/*
+   Dedicated interrupt stack, switched on trap entry via mscratch.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef ISR_STACK_HPP
+#define ISR_STACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "riscv-csr.hpp"
+
+// These symbols are defined by the linker script.
+// See linker.lds
+extern "C" std::uint8_t metal_segment_stack_begin;
+extern "C" std::uint8_t metal_segment_stack_end;
+extern "C" std::uint8_t metal_segment_isr_stack_begin;
+extern "C" std::uint8_t metal_segment_isr_stack_end;
+
+#if (__riscv_xlen == 64)
+#define RISCV_ISR_STACK_STORE    "sd"
+#define RISCV_ISR_STACK_LOAD     "ld"
+#define RISCV_ISR_STACK_REGBYTES "8"
+#else
+#define RISCV_ISR_STACK_STORE    "sw"
+#define RISCV_ISR_STACK_LOAD     "lw"
+#define RISCV_ISR_STACK_REGBYTES "4"
+#endif
+// 20 registers keeps the stack 16 byte aligned for RV32 and RV64.
+#define RISCV_ISR_STACK_FRAME        "20*" RISCV_ISR_STACK_REGBYTES
+#define RISCV_ISR_STACK_SAVE(REG, N)    RISCV_ISR_STACK_STORE " " #REG ", " #N "*" RISCV_ISR_STACK_REGBYTES "(sp);"
+#define RISCV_ISR_STACK_RESTORE(REG, N) RISCV_ISR_STACK_LOAD  " " #REG ", " #N "*" RISCV_ISR_STACK_REGBYTES "(sp);"
+
+namespace riscv {
+
+    /** Dedicated interrupt stack, allocated by linker.lds with size __isr_stack_size.
+
+        The size is set at link time, the default size is 0:
+
+            -Xlinker --defsym=__isr_stack_size=0x400
+
+        While no trap is being handled mscratch holds the top of the interrupt
+        stack. On entry sp and mscratch are swapped, and mscratch is set to 0
+        while the handler runs. A nested trap finds mscratch == 0 and stays on
+        the interrupt stack.
+
+        Usage:
+            static void irq_handler(void);  // Plain function, not interrupt ("machine")
+            riscv::isr_stack::init();
+            riscv::csrs.mtvec.write(reinterpret_cast<std::uintptr_t>(riscv::isr_stack::entry<irq_handler>));
+     */
+    struct isr_stack {
+        /** Fill pattern of unused stack memory, for the stack usage report */
+        static constexpr std::uint32_t PAINT = 0x5AA5A55A;
+        /** Space left unpainted below the current stack pointer for init() */
+        static constexpr std::size_t PAINT_MARGIN = 64;
+
+        /** Paint the interrupt stack and the unused part of the main stack for the stack usage report,
+            then set mscratch to the top of the interrupt stack.
+            Call before enabling interrupts. There is one interrupt stack, for hart 0.
+         */
+        static void init(void) {
+            paint(reinterpret_cast<std::uint32_t *>(&metal_segment_isr_stack_begin),
+                  reinterpret_cast<std::uint32_t *>(&metal_segment_isr_stack_end));
+            // The main stack is in use, only paint below this frame
+            auto sp = reinterpret_cast<std::uintptr_t>(__builtin_frame_address(0)) - PAINT_MARGIN;
+            paint(reinterpret_cast<std::uint32_t *>(&metal_segment_stack_begin),
+                  reinterpret_cast<std::uint32_t *>(sp & ~static_cast<std::uintptr_t>(3)));
+            riscv::csrs.mscratch.write(reinterpret_cast<std::uintptr_t>(&metal_segment_isr_stack_end));
+        }
+
+        /** Maximum number of bytes used on the main stack since init() */
+        static std::size_t usage_main(void) {
+            return usage(reinterpret_cast<const std::uint32_t *>(&metal_segment_stack_begin),
+                         reinterpret_cast<const std::uint32_t *>(&metal_segment_stack_end));
+        }
+
+        /** Maximum number of bytes used on the interrupt stack since init() */
+        static std::size_t usage_isr(void) {
+            return usage(reinterpret_cast<const std::uint32_t *>(&metal_segment_isr_stack_begin),
+                         reinterpret_cast<const std::uint32_t *>(&metal_segment_isr_stack_end));
+        }
+
+        /** Trap entry that runs the plain function HANDLER on the interrupt stack.
+            Use as the direct mode mtvec, or as the target of a vector table entry.
+            HANDLER must not be an interrupt ("machine") function, the entry saves the caller saved registers and returns with mret.
+            If HANDLER sets mstatus.MIE it must clear it again before returning.
+         */
+        template<void (*HANDLER)(void)>
+        static void entry(void) __attribute__ ((naked, aligned(4)));
+
+    private :
+        static void paint(std::uint32_t *begin, std::uint32_t *end) {
+            for (volatile std::uint32_t *p = begin; p < end; p++) {
+                *p = PAINT;
+            }
+        }
+        // Stacks grow down, the usage is from the lowest overwritten word to the end.
+        static std::size_t usage(const std::uint32_t *begin, const std::uint32_t *end) {
+            const volatile std::uint32_t *p = begin;
+            while ((p < end) && (*p == PAINT)) {
+                p++;
+            }
+            return reinterpret_cast<const std::uint8_t *>(end) - reinterpret_cast<const volatile std::uint8_t *>(p);
+        }
+    };
+
+    template<void (*HANDLER)(void)>
+    void isr_stack::entry(void) {
+        __asm__ volatile (
+            "csrrw sp, mscratch, sp;"
+            "bnez  sp, 1f;"
+            // Nested trap, already on the interrupt stack. mscratch = 0
+            "csrrw sp, mscratch, sp;"
+            "addi  sp, sp, -" RISCV_ISR_STACK_FRAME ";"
+            RISCV_ISR_STACK_SAVE(t0, 0)
+            "addi  t0, sp, " RISCV_ISR_STACK_FRAME ";"
+            RISCV_ISR_STACK_SAVE(t0, 18)
+            RISCV_ISR_STACK_SAVE(zero, 19)
+            "j     2f;"
+            "1:"
+            // From the interrupted program. mscratch = interrupted sp
+            "addi  sp, sp, -" RISCV_ISR_STACK_FRAME ";"
+            RISCV_ISR_STACK_SAVE(t0, 0)
+            "addi  t0, sp, " RISCV_ISR_STACK_FRAME ";"
+            RISCV_ISR_STACK_SAVE(t0, 19)
+            "csrrw t0, mscratch, zero;"
+            RISCV_ISR_STACK_SAVE(t0, 18)
+            "2:"
+            RISCV_ISR_STACK_SAVE(ra, 1)
+            RISCV_ISR_STACK_SAVE(t1, 2)
+            RISCV_ISR_STACK_SAVE(t2, 3)
+            RISCV_ISR_STACK_SAVE(t3, 4)
+            RISCV_ISR_STACK_SAVE(t4, 5)
+            RISCV_ISR_STACK_SAVE(t5, 6)
+            RISCV_ISR_STACK_SAVE(t6, 7)
+            RISCV_ISR_STACK_SAVE(a0, 8)
+            RISCV_ISR_STACK_SAVE(a1, 9)
+            RISCV_ISR_STACK_SAVE(a2, 10)
+            RISCV_ISR_STACK_SAVE(a3, 11)
+            RISCV_ISR_STACK_SAVE(a4, 12)
+            RISCV_ISR_STACK_SAVE(a5, 13)
+            RISCV_ISR_STACK_SAVE(a6, 14)
+            RISCV_ISR_STACK_SAVE(a7, 15)
+            "call  %0;"
+            RISCV_ISR_STACK_RESTORE(ra, 1)
+            RISCV_ISR_STACK_RESTORE(t1, 2)
+            RISCV_ISR_STACK_RESTORE(t2, 3)
+            RISCV_ISR_STACK_RESTORE(t3, 4)
+            RISCV_ISR_STACK_RESTORE(t4, 5)
+            RISCV_ISR_STACK_RESTORE(t5, 6)
+            RISCV_ISR_STACK_RESTORE(t6, 7)
+            RISCV_ISR_STACK_RESTORE(a0, 8)
+            RISCV_ISR_STACK_RESTORE(a1, 9)
+            RISCV_ISR_STACK_RESTORE(a2, 10)
+            RISCV_ISR_STACK_RESTORE(a3, 11)
+            RISCV_ISR_STACK_RESTORE(a4, 12)
+            RISCV_ISR_STACK_RESTORE(a5, 13)
+            RISCV_ISR_STACK_RESTORE(a6, 14)
+            RISCV_ISR_STACK_RESTORE(a7, 15)
+            // Top of the interrupt stack when leaving the outer trap, else 0
+            RISCV_ISR_STACK_RESTORE(t0, 19)
+            "csrw  mscratch, t0;"
+            RISCV_ISR_STACK_RESTORE(t0, 0)
+            RISCV_ISR_STACK_RESTORE(sp, 18)
+            "mret;"
+            : /* output: none */
+            : /* input : immediate */ "i"(HANDLER)
+            : /* clobbers: none */
+            );
+    }
+
+} /* riscv */
+
+#endif // #ifdef ISR_STACK_HPP
@@ -17,15 +17,45 @@
 #include "riscv-csr.hpp"
 #include "riscv-interrupts.hpp"
 #include "timer.hpp"
-
+#include "seqlock.hpp"
+#include "irq_storm.hpp"
+#include "trap_dispatch.hpp"
+#include "isr_stack.hpp"
+
+#ifdef IRQ_ISR_STACK
+// Interrupt service routine, called by riscv::isr_stack::entry<irq_entry> on the interrupt stack
+static void irq_entry(void) noexcept;
+#else
 // Machine mode interrupt service routine
 static void irq_entry(void) noexcept __attribute__ ((interrupt ("machine")));
+#endif
+
+// Handlers called by irq_entry
+static void irq_nop(void) {}
+static void mti_handler(void);
+
+// Handler tables indexed by cause, one indirect call per interrupt
+using irq_interrupts = riscv::dispatch_table<16, irq_nop,
+                                             riscv::dispatch_vector<riscv::interrupts::mti, mti_handler>>;
+using irq_exceptions = riscv::dispatch_table<16, irq_nop>;
+
+// Tail chain pending interrupts in irq_entry, rather than return and re-enter.
+static constexpr bool irq_tail_chain = true;
+
+// Mask an interrupt cause that exceeds a rate limit in irq_entry, e.g. a timer programmed with a 0 period.
+static constexpr bool irq_storm_detect = true;
+using irq_storm = riscv::irq_storm<>;
 
 // Timer driver 
 static driver::timer<> mtimer;
 
-// Global to hold current timestamp
-static volatile uint64_t timestamp{0};
+// Global to hold current timestamp, written in irq_entry. A 64 bit read on RV32 could be torn by the interrupt.
+static riscv::seqlock<uint64_t> timestamp;
+// Copy of timestamp read by main() after each wakeup
+static volatile uint64_t wakeup_timestamp{0};
+// Bytes used on the main and interrupt stacks, only updated when built with IRQ_ISR_STACK
+static volatile std::size_t stack_usage_main{0};
+static volatile std::size_t stack_usage_isr{0};
 
 // Class to perform constructor/destructor before main()
 template<uint32_t V>
@@ -70,10 +100,15 @@ int main(void) {
     riscv::csrs.mstatus.mie.clr();
 
     // Setup timer for 1 second interval
-    timestamp = mtimer.get_time<driver::timer<>::timer_ticks>().count();
+    timestamp.write(mtimer.get_time<driver::timer<>::timer_ticks>().count());
     mtimer.set_time_cmp(std::chrono::seconds{1});
     // Setup the IRQ handler entry point
+#ifdef IRQ_ISR_STACK
+    riscv::isr_stack::init();
+    riscv::csrs.mtvec.write(reinterpret_cast<std::uintptr_t>(riscv::isr_stack::entry<irq_entry>));
+#else
     riscv::csrs.mtvec.write( reinterpret_cast<std::uintptr_t>(irq_entry));
+#endif
 
     // Timer interrupt enable
     riscv::csrs.mie.mti.set();
@@ -95,6 +130,11 @@ int main(void) {
     do {
         __asm__ volatile ("wfi");  
         global_value_with_init++;
+        wakeup_timestamp = timestamp.read();
+#ifdef IRQ_ISR_STACK
+        stack_usage_main = riscv::isr_stack::usage_main();
+        stack_usage_isr = riscv::isr_stack::usage_isr();
+#endif
     } while (global_bool_keep_running);
 
     // Global interrupt disable
@@ -109,17 +149,39 @@ int main(void) {
 static void irq_entry(void)  {
     auto this_cause = riscv::csrs.mcause.read();
     if (this_cause &  riscv::csr::mcause_data::interrupt::BIT_MASK) {
-        this_cause &= 0xFF;
-        // Known exceptions
-        switch (this_cause) {
-        case riscv::interrupts::mti :
-            // Timer exception, keep up the one second tick.
-            mtimer.set_time_cmp(std::chrono::seconds{1});
-            timestamp = mtimer.get_time<driver::timer<>::timer_ticks>().count();
-            break;
-        }
+        this_cause &= irq_interrupts::MASK;
+        do {
+            // Over the rate limit, the cause is masked in mie and is not handled
+            bool handle = true;
+            if constexpr (irq_storm_detect) {
+                handle = irq_storm::account(this_cause, mtimer.get_raw_time());
+            }
+            if (handle) {
+                irq_interrupts::dispatch(this_cause);
+            }
+            if constexpr (!irq_tail_chain) {
+                break;
+            }
+            // Before returning, handle any other enabled and pending interrupt without a new trap entry.
+            // Only causes in the table, another cause would alias by MASK and be chained forever.
+            auto pending = riscv::csrs.mip.read() & riscv::csrs.mie.read() & irq_interrupts::HANDLED;
+            if (pending == 0) {
+                break;
+            }
+            this_cause = riscv::interrupts::next_pending(pending);
+        } while (true);
+    } else {
+        irq_exceptions::dispatch(this_cause);
     }
 }
 #pragma GCC pop_options
 
+static void mti_handler(void) {
+    // No-op unless the timer is instantiated with driver::latency_stats<>
+    mtimer.record_latency();
+    // Timer exception, keep up the one second tick.
+    mtimer.set_time_cmp(std::chrono::seconds{1});
+    timestamp.write(mtimer.get_time<driver::timer<>::timer_ticks>().count());
+}
+
     
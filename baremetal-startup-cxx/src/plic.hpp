@@ -0,0 +1,170 @@
+/*
+   Platform-Level Interrupt Controller (PLIC) driver.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef PLIC_HPP
+#define PLIC_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+namespace driver {
+
+    /** Default definition of the memory mapped PLIC registers.
+    The layout is from the RISC-V PLIC specification, the base address and number of sources
+    are from freedom-e-sdk/bsp/sifive-hifive1-revb/design.svd (also the QEMU sifive_e machine).
+    */
+    struct plic_address_spec {
+        static constexpr std::uintptr_t BASE_ADDR = 0x0C000000;
+        // Source priority, 4 bytes per source. Source 0 does not exist.
+        static constexpr std::uintptr_t PRIORITY_OFFSET = 0x000000;
+        // Pending bits, 1 bit per source
+        static constexpr std::uintptr_t PENDING_OFFSET = 0x001000;
+        // Enable bits, 1 bit per source, per context
+        static constexpr std::uintptr_t ENABLE_OFFSET = 0x002000;
+        static constexpr std::uintptr_t ENABLE_STRIDE = 0x80;
+        // Threshold and claim/complete registers, per context
+        static constexpr std::uintptr_t CONTEXT_OFFSET = 0x200000;
+        static constexpr std::uintptr_t CONTEXT_STRIDE = 0x1000;
+        static constexpr std::uintptr_t THRESHOLD_OFFSET = 0x0;
+        static constexpr std::uintptr_t CLAIM_OFFSET = 0x4;
+        // Number of sources including the non-existent source 0
+        static constexpr std::size_t NUM_SOURCES = 53;
+        static constexpr std::uint32_t MAX_PRIORITY = 7;
+    };
+
+    /** PLIC of the QEMU virt machine. Context 0 is hart 0 M-mode, context 1 is hart 0 S-mode.
+    */
+    struct plic_qemu_virt_address_spec : plic_address_spec {
+        static constexpr std::size_t NUM_SOURCES = 96;
+    };
+
+    /** Handler of a PLIC source, a plain function called by plic::handle() */
+    using plic_handler = void (*)(void);
+
+    /** Entry of a PLIC dispatch table, the handler of a source.
+        @tparam SOURCE Interrupt source ID, 1 to NUM_SOURCES-1
+        @tparam HANDLER Plain function, not an interrupt ("machine") function.
+     */
+    template<std::uint32_t SOURCE, plic_handler HANDLER>
+    struct plic_vector {
+        static constexpr std::uint32_t source = SOURCE;
+        static constexpr plic_handler handler = HANDLER;
+    };
+
+    /** PLIC driver for one context (a hart and privilege mode).
+
+        Usage:
+            using plic = driver::plic<>;
+            using plic_table = plic::table<unhandled, driver::plic_vector<3, uart0_handler>>;
+
+            plic::set_priority(3, 1);
+            plic::enable(3);
+            plic::set_threshold(0);
+            riscv::csrs.mie.mei.set();
+
+            // MEI handler
+            static void mei_handler(void) { plic::handle<plic_table>(); }
+
+        @tparam ADDRESS_SPEC Register addresses, see plic_address_spec.
+        @tparam CONTEXT PLIC context, 0 is hart 0 M-mode on the sifive_e and QEMU virt machines.
+     */
+    template<class ADDRESS_SPEC=plic_address_spec, std::size_t CONTEXT=0>
+    class plic {
+    public :
+        static constexpr std::size_t NUM_SOURCES = ADDRESS_SPEC::NUM_SOURCES;
+
+        /** Dispatch table of handlers indexed by source ID, generated at compile time.
+            Sources that are not listed call DEFAULT_HANDLER.
+         */
+        template<plic_handler DEFAULT_HANDLER, class... VECTORS>
+        struct table {
+            static_assert(((VECTORS::source > 0 && VECTORS::source < NUM_SOURCES) && ...), "PLIC source is outside the dispatch table");
+
+            struct handlers_t {
+                plic_handler handler[NUM_SOURCES];
+            };
+            static constexpr handlers_t make(void) {
+                handlers_t t{};
+                for (std::size_t i = 0; i < NUM_SOURCES; i++) {
+                    t.handler[i] = DEFAULT_HANDLER;
+                }
+                ((t.handler[VECTORS::source] = VECTORS::handler), ...);
+                return t;
+            }
+            static constexpr handlers_t handlers = make();
+
+            /** Call the handler of a claimed source */
+            static void dispatch(std::uint32_t source) {
+                handlers.handler[source < NUM_SOURCES ? source : 0]();
+            }
+        };
+
+        /** Set the priority of a source, 0 disables the source. */
+        static void set_priority(std::uint32_t source, std::uint32_t priority) {
+            *reg(ADDRESS_SPEC::PRIORITY_OFFSET + source*4) = priority;
+        }
+        /** Sources with a priority at or below the threshold are masked for this context. */
+        static void set_threshold(std::uint32_t threshold) {
+            *context_reg(ADDRESS_SPEC::THRESHOLD_OFFSET) = threshold;
+        }
+        /** Enable a source for this context. Not atomic, enable sources before enabling interrupts. */
+        static void enable(std::uint32_t source) {
+            auto r = enable_reg(source);
+            *r = *r | enable_bit(source);
+        }
+        /** Disable a source for this context. */
+        static void disable(std::uint32_t source) {
+            auto r = enable_reg(source);
+            *r = *r & ~enable_bit(source);
+        }
+        /** Test if a source is pending. */
+        static bool pending(std::uint32_t source) {
+            return (*reg(ADDRESS_SPEC::PENDING_OFFSET + (source/32)*4) & enable_bit(source)) != 0;
+        }
+        /** Claim the highest priority pending source, 0 if none is pending. */
+        static std::uint32_t claim(void) {
+            return *context_reg(ADDRESS_SPEC::CLAIM_OFFSET);
+        }
+        /** Signal the handling of a claimed source is complete. */
+        static void complete(std::uint32_t source) {
+            *context_reg(ADDRESS_SPEC::CLAIM_OFFSET) = source;
+        }
+
+        /** Claim, dispatch and complete sources until the PLIC returns 0.
+            All sources pending at entry, or raised while handling, are handled by one trap.
+            @tparam TABLE plic::table<> dispatch table.
+            @return Number of sources handled.
+         */
+        template<class TABLE> static unsigned int handle(void) {
+            unsigned int count = 0;
+            for (std::uint32_t source = claim(); source != 0; source = claim()) {
+                TABLE::dispatch(source);
+                complete(source);
+                count++;
+            }
+            return count;
+        }
+
+    private :
+        static volatile std::uint32_t *reg(std::uintptr_t offset) {
+            return reinterpret_cast<volatile std::uint32_t *>(ADDRESS_SPEC::BASE_ADDR + offset);
+        }
+        static volatile std::uint32_t *context_reg(std::uintptr_t offset) {
+            return reg(ADDRESS_SPEC::CONTEXT_OFFSET + CONTEXT*ADDRESS_SPEC::CONTEXT_STRIDE + offset);
+        }
+        static volatile std::uint32_t *enable_reg(std::uint32_t source) {
+            return reg(ADDRESS_SPEC::ENABLE_OFFSET + CONTEXT*ADDRESS_SPEC::ENABLE_STRIDE + (source/32)*4);
+        }
+        static constexpr std::uint32_t enable_bit(std::uint32_t source) {
+            return static_cast<std::uint32_t>(1) << (source % 32);
+        }
+    };
+
+} /* driver */
+
+#endif // #ifdef PLIC_HPP
@@ -0,0 +1,247 @@
+/*
+   Compile time planned Physical Memory Protection (PMP) configuration.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef PMP_HPP
+#define PMP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "riscv-csr.hpp"
+
+namespace riscv {
+
+    /** Physical Memory Protection, planned at compile time.
+
+        A list of regions, e.g. the MEMORY map of linker.lds and the MMIO
+        devices, is converted to pmpaddr and packed pmpcfg values by a
+        constexpr planner. Each region uses the fewest entries:
+
+        - NA4:   a 4 byte region, 1 entry.
+        - NAPOT: a power of 2 size, aligned to the size, 1 entry.
+        - TOR:   any other region, 1 entry when the previous entry is a TOR
+                 region ending at the base (or the base is 0 in entry 0),
+                 otherwise 2 entries, an OFF entry holds the base.
+
+        The regions are sorted by base, so adjacent TOR regions share the
+        boundary entry. A TOR region is also preferred to NAPOT when it
+        chains, at the same cost, so the next region can chain.
+
+        program<PLAN>::write() is straight line csrw of constants, there is
+        no computation at boot.
+
+        Usage:
+
+            static constexpr riscv::pmp::region memory_map[] = {
+                {0x20010000, 0x6a120, riscv::pmp::R | riscv::pmp::X},
+                {0x80000000, 0x4000,  riscv::pmp::R | riscv::pmp::W},
+            };
+            static constexpr riscv::pmp::plan_t pmp_plan = riscv::pmp::make_plan(memory_map);
+            riscv::pmp::program<pmp_plan>::write();
+
+        Entries without L only restrict S-mode and U-mode. With L the entry
+        also applies to M-mode, and can not be changed until reset.
+     */
+    namespace pmp {
+
+        /** pmpcfg permission and lock bits */
+        static constexpr std::uint8_t R = 0x01;
+        static constexpr std::uint8_t W = 0x02;
+        static constexpr std::uint8_t X = 0x04;
+        static constexpr std::uint8_t L = 0x80;
+
+        /** pmpcfg.A address matching mode */
+        static constexpr std::uint8_t A_OFF   = 0x00;
+        static constexpr std::uint8_t A_TOR   = 0x08;
+        static constexpr std::uint8_t A_NA4   = 0x10;
+        static constexpr std::uint8_t A_NAPOT = 0x18;
+
+        /** Number of PMP entries */
+        static constexpr std::size_t ENTRIES = 16;
+#if (__riscv_xlen == 64)
+        /** Entries packed in each pmpcfg register, RV64 uses the even registers only */
+        static constexpr std::size_t CFG_PER_REG = 8;
+#else
+        /** Entries packed in each pmpcfg register */
+        static constexpr std::size_t CFG_PER_REG = 4;
+#endif
+        static constexpr std::size_t CFG_REGS = ENTRIES / CFG_PER_REG;
+
+        /** CSR numbers */
+        static constexpr unsigned PMPCFG0  = 0x3A0;
+        static constexpr unsigned PMPADDR0 = 0x3B0;
+
+        /** A memory region and its permissions. base and size are multiples of 4. */
+        struct region {
+            std::uintptr_t base;
+            std::uintptr_t size;
+            std::uint8_t perm;      // R, W, X and L
+        };
+
+        /** Reason a plan can not be programmed */
+        enum class error {
+            none,
+            empty,              // A region with size 0
+            alignment,          // base or size is not a multiple of 4
+            overlap,            // Regions overlap, the priority would depend on the order
+            too_many_entries,   // More than ENTRIES entries
+        };
+
+        /** PMP configuration, entries first to first+count-1 are used. */
+        struct plan_t {
+            error err;
+            std::size_t first;
+            std::size_t count;
+            riscv::csr::uint_xlen_t addr[ENTRIES];          // pmpaddr, indexed by entry
+            riscv::csr::uint_xlen_t cfg[CFG_REGS];          // Packed pmpcfg bytes
+            riscv::csr::uint_xlen_t cfg_mask[CFG_REGS];     // pmpcfg bytes set by the plan
+        };
+
+        /** Plan the PMP entries of 'regions', starting at entry 'first'.
+            The lower entries can be left for regions with a higher priority,
+            e.g. the stack guards of baremetal-startup-c/src/stack_guard.h.
+         */
+        template<std::size_t N>
+        constexpr plan_t make_plan(const region (&regions)[N], std::size_t first = 0) {
+            plan_t p{};
+            p.err = error::none;
+            p.first = first;
+
+            // Sort by base
+            region sorted[N] = {};
+            for (std::size_t i = 0; i < N; i++) {
+                std::size_t j = i;
+                for (; (j > 0) && (sorted[j - 1].base > regions[i].base); j--) {
+                    sorted[j] = sorted[j - 1];
+                }
+                sorted[j] = regions[i];
+            }
+
+            std::size_t entry = first;
+            // pmpaddr of the last TOR entry, the base of a following TOR entry.
+            // The base of a TOR region in entry 0 is 0.
+            bool tor_chain = (first == 0);
+            riscv::csr::uint_xlen_t tor_top = 0;
+            auto set_entry = [&p, &entry](riscv::csr::uint_xlen_t addr, std::uint8_t cfg) {
+                p.addr[entry] = addr;
+                const std::size_t shift = 8 * (entry % CFG_PER_REG);
+                p.cfg[entry / CFG_PER_REG] |= static_cast<riscv::csr::uint_xlen_t>(cfg) << shift;
+                p.cfg_mask[entry / CFG_PER_REG] |= static_cast<riscv::csr::uint_xlen_t>(0xFF) << shift;
+                entry++;
+            };
+
+            for (std::size_t i = 0; i < N; i++) {
+                const region &r = sorted[i];
+                // Addresses in pmpaddr units, bits [XLEN+1:2], the top does not overflow.
+                const riscv::csr::uint_xlen_t base = r.base >> 2;
+                const riscv::csr::uint_xlen_t top = base + (r.size >> 2);
+                if (r.size == 0) {
+                    p.err = error::empty;
+                    return p;
+                }
+                if (((r.base | r.size) & 0x3) != 0) {
+                    p.err = error::alignment;
+                    return p;
+                }
+                if ((i > 0) && (base < ((sorted[i - 1].base >> 2) + (sorted[i - 1].size >> 2)))) {
+                    p.err = error::overlap;
+                    return p;
+                }
+                const bool tor_1 = tor_chain && (tor_top == base);
+                const bool napot = ((r.size & (r.size - 1)) == 0) && ((r.base & (r.size - 1)) == 0);
+                const std::size_t needed = (tor_1 || napot) ? 1 : 2;
+                if ((entry + needed) > ENTRIES) {
+                    p.err = error::too_many_entries;
+                    return p;
+                }
+                if (tor_1) {
+                    set_entry(top, A_TOR | r.perm);
+                    tor_top = top;
+                } else if (napot) {
+                    if (r.size == 4) {
+                        set_entry(base, A_NA4 | r.perm);
+                    } else {
+                        set_entry(base | ((r.size >> 3) - 1), A_NAPOT | r.perm);
+                    }
+                    tor_chain = false;
+                } else {
+                    set_entry(base, A_OFF);
+                    set_entry(top, A_TOR | r.perm);
+                    tor_chain = true;
+                    tor_top = top;
+                }
+            }
+            p.count = entry - first;
+            return p;
+        }
+
+        /** Write a CSR by number */
+        template<unsigned CSR>
+        static inline void csr_write(riscv::csr::uint_xlen_t value) {
+            __asm__ volatile ("csrw    %0, %1"
+                              : /* output: none */
+                              : "i" (CSR), "r" (value)
+                              : /* clobbers: none */);
+        }
+
+        /** Clear then set the bits of a CSR by number, the other bits are not changed */
+        template<unsigned CSR>
+        static inline void csr_clr_set(riscv::csr::uint_xlen_t clr, riscv::csr::uint_xlen_t set) {
+            __asm__ volatile ("csrc    %0, %1;"
+                              "csrs    %0, %2"
+                              : /* output: none */
+                              : "i" (CSR), "r" (clr), "r" (set)
+                              : /* clobbers: none */);
+        }
+
+        /** Program the entries of a plan. The pmpcfg bytes of entries
+            outside the plan are not changed, a locked entry is not changed.
+            @tparam PLAN A constexpr plan_t with static storage.
+         */
+        template<const plan_t &PLAN>
+        struct program {
+            static_assert(PLAN.err != error::empty, "PMP region with size 0");
+            static_assert(PLAN.err != error::alignment, "PMP region base and size must be multiples of 4");
+            static_assert(PLAN.err != error::overlap, "PMP regions overlap");
+            static_assert(PLAN.err != error::too_many_entries, "PMP regions need more than 16 entries");
+
+            /** Write pmpaddr then pmpcfg, an entry is enabled after its address is set */
+            static inline void write(void) {
+                write_addr(std::make_index_sequence<PLAN.count>{});
+                write_cfg(std::make_index_sequence<CFG_REGS>{});
+            }
+
+        private:
+            template<std::size_t... I>
+            static inline void write_addr(std::index_sequence<I...>) {
+                (csr_write<PMPADDR0 + PLAN.first + I>(PLAN.addr[PLAN.first + I]), ...);
+            }
+
+            // RV64 has pmpcfg0 and pmpcfg2 only
+            template<std::size_t REG>
+            static inline void write_cfg_reg(void) {
+                constexpr unsigned CSR = PMPCFG0 + REG * (CFG_PER_REG / 4);
+                if constexpr (PLAN.cfg_mask[REG] == static_cast<riscv::csr::uint_xlen_t>(-1)) {
+                    csr_write<CSR>(PLAN.cfg[REG]);
+                } else if constexpr (PLAN.cfg_mask[REG] != 0) {
+                    csr_clr_set<CSR>(PLAN.cfg_mask[REG], PLAN.cfg[REG]);
+                }
+            }
+
+            template<std::size_t... I>
+            static inline void write_cfg(std::index_sequence<I...>) {
+                (write_cfg_reg<I>(), ...);
+            }
+        };
+
+    } /* pmp */
+
+} /* riscv */
+
+#endif // #ifdef PMP_HPP
@@ -645,6 +645,30 @@ namespace riscv {
                 static constexpr uint_xlen_t BIT_MASK   = 0x100;
                 static constexpr uint_xlen_t ALL_SET_MASK = 0x1;
             };
+            /** Parameter data for fs */
+            struct fs {
+                using datatype = uint_xlen_t;
+                static constexpr uint_xlen_t BIT_OFFSET = 13;
+                static constexpr uint_xlen_t BIT_WIDTH  = 2;
+                static constexpr uint_xlen_t BIT_MASK   = 0x6000;
+                static constexpr uint_xlen_t ALL_SET_MASK = 0x3;
+            };
+            /** Parameter data for xs */
+            struct xs {
+                using datatype = uint_xlen_t;
+                static constexpr uint_xlen_t BIT_OFFSET = 15;
+                static constexpr uint_xlen_t BIT_WIDTH  = 2;
+                static constexpr uint_xlen_t BIT_MASK   = 0x18000;
+                static constexpr uint_xlen_t ALL_SET_MASK = 0x3;
+            };
+            /** Parameter data for sd */
+            struct sd {
+                using datatype = uint_xlen_t;
+                static constexpr uint_xlen_t BIT_OFFSET = (__riscv_xlen-1);
+                static constexpr uint_xlen_t BIT_WIDTH  = 1;
+                static constexpr uint_xlen_t BIT_MASK   = (0x1UL << ((__riscv_xlen-1)));
+                static constexpr uint_xlen_t ALL_SET_MASK = 0x1;
+            };
         } /* mstatus_data */
 
         // ----------------------------------------------------------------
@@ -13063,6 +13087,534 @@ namespace riscv {
             }
             
         }; /* mtval2_ops */
+
+        // ----------------------------------------------------------------
+        // stimecmp - SRW - Supervisor Timer Compare (Sstc) 
+        //
+        /** Supervisor Timer Compare (Sstc) assembler operations */
+        struct stimecmp_ops  {
+            using datatype = uint_csr64_t;
+            static constexpr priv_t priv = SRW; 
+            
+            /** Read stimecmp */
+            static uint64_t read(void) {
+                uint_csr64_t value;        
+                __asm__ volatile ("csrr    %0, stimecmp" 
+                                  : "=r" (value)  /* output : register */
+                                  : /* input : none */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            
+            
+            /** Write stimecmp */
+            static void write(uint_csr64_t value) {
+                __asm__ volatile ("csrw    stimecmp, %0" 
+                                  : /* output: none */ 
+                                  : "r" (value) /* input : from register */
+                                  : /* clobbers: none */);
+            }
+            /** Write immediate value to stimecmp */
+            static void write_imm(uint_csr64_t value) {
+                __asm__ volatile ("csrwi    stimecmp, %0" 
+                                  : /* output: none */ 
+                                  : "i" (value) /* input : from immediate */
+                                  : /* clobbers: none */);
+            }
+            /** Read and then write to stimecmp */
+            static uint64_t read_write(uint_csr64_t new_value) {
+                uint_csr64_t prev_value;
+                __asm__ volatile ("csrrw    %0, stimecmp, %1"  
+                                  : "=r" (prev_value) /* output: register %0 */
+                                  : "r" (new_value)  /* input : register */
+                                  : /* clobbers: none */);
+                return prev_value;
+            }
+            /** Read and then write immediate value to stimecmp */
+            static uint64_t read_write_imm(const uint8_t new_value) {
+                uint_csr64_t prev_value;
+                __asm__ volatile ("csrrwi    %0, stimecmp, %1"  
+                                  : "=r" (prev_value) /* output: register %0 */
+                                  : "i" (new_value)  /* input : register */
+                                  : /* clobbers: none */);
+                return prev_value;
+            }
+        
+            // ------------------------------------------
+            // Register CSR bit set and clear instructions
+
+            /** Atomic modify and set bits for stimecmp */
+            static void set_bits(uint_csr64_t mask) {
+                __asm__ volatile ("csrrs    zero, stimecmp, %0"  
+                                  : /* output: none */ 
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and set bits for stimecmp */
+            static uint32_t read_set_bits(uint_csr64_t mask) {
+                uint_csr64_t value;
+                __asm__ volatile ("csrrs    %0, stimecmp, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            /** Atomic modify and clear bits for stimecmp */
+            static void clr_bits(uint_csr64_t mask) {
+                __asm__ volatile ("csrrc    zero, stimecmp, %0"  
+                                  : /* output: none */ 
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and clear bits for stimecmp */
+            static uint32_t read_clr_bits(uint_csr64_t mask) {
+                uint_csr64_t value;
+                __asm__ volatile ("csrrc    %0, stimecmp, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+        
+            // ------------------------------------------
+            // Immediate value CSR bit set and clear instructions (only up to 5 bits)
+        
+            /** Atomic modify and set bits from immediate for stimecmp */
+            static void set_bits_imm(const uint8_t mask) {
+                __asm__ volatile ("csrrsi    zero, stimecmp, %0"  
+                                  : /* output: none */ 
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and set bits from immediate for stimecmp */
+            static uint64_t read_set_bits_imm(const uint8_t mask) {
+                uint_csr64_t value;
+                __asm__ volatile ("csrrsi    %0, stimecmp, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            /** Atomic modify and clear bits from immediate for stimecmp */
+            static void clr_bits_imm(const uint8_t mask) {
+                __asm__ volatile ("csrrci    zero, stimecmp, %0"  
+                                  : /* output: none */ 
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and clear bits from immediate for stimecmp */
+            static uint64_t read_clr_bits_imm(const uint8_t mask) {
+                uint_csr64_t value;
+                __asm__ volatile ("csrrci    %0, stimecmp, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            
+        }; /* stimecmp_ops */
+
+        // ----------------------------------------------------------------
+        // stimecmph - SRW - Upper 32 bits of  stimecmp, RV32 only. 
+        //
+        /** Upper 32 bits of  stimecmp, RV32 only. assembler operations */
+        struct stimecmph_ops  {
+            using datatype = uint_csr32_t;
+            static constexpr priv_t priv = SRW; 
+            
+            /** Read stimecmph */
+            static uint32_t read(void) {
+                uint_csr32_t value;        
+                __asm__ volatile ("csrr    %0, stimecmph" 
+                                  : "=r" (value)  /* output : register */
+                                  : /* input : none */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            
+            
+            /** Write stimecmph */
+            static void write(uint_csr32_t value) {
+                __asm__ volatile ("csrw    stimecmph, %0" 
+                                  : /* output: none */ 
+                                  : "r" (value) /* input : from register */
+                                  : /* clobbers: none */);
+            }
+            /** Write immediate value to stimecmph */
+            static void write_imm(uint_csr32_t value) {
+                __asm__ volatile ("csrwi    stimecmph, %0" 
+                                  : /* output: none */ 
+                                  : "i" (value) /* input : from immediate */
+                                  : /* clobbers: none */);
+            }
+            /** Read and then write to stimecmph */
+            static uint32_t read_write(uint_csr32_t new_value) {
+                uint_csr32_t prev_value;
+                __asm__ volatile ("csrrw    %0, stimecmph, %1"  
+                                  : "=r" (prev_value) /* output: register %0 */
+                                  : "r" (new_value)  /* input : register */
+                                  : /* clobbers: none */);
+                return prev_value;
+            }
+            /** Read and then write immediate value to stimecmph */
+            static uint32_t read_write_imm(const uint8_t new_value) {
+                uint_csr32_t prev_value;
+                __asm__ volatile ("csrrwi    %0, stimecmph, %1"  
+                                  : "=r" (prev_value) /* output: register %0 */
+                                  : "i" (new_value)  /* input : register */
+                                  : /* clobbers: none */);
+                return prev_value;
+            }
+        
+            // ------------------------------------------
+            // Register CSR bit set and clear instructions
+
+            /** Atomic modify and set bits for stimecmph */
+            static void set_bits(uint_csr32_t mask) {
+                __asm__ volatile ("csrrs    zero, stimecmph, %0"  
+                                  : /* output: none */ 
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and set bits for stimecmph */
+            static uint32_t read_set_bits(uint_csr32_t mask) {
+                uint_csr32_t value;
+                __asm__ volatile ("csrrs    %0, stimecmph, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            /** Atomic modify and clear bits for stimecmph */
+            static void clr_bits(uint_csr32_t mask) {
+                __asm__ volatile ("csrrc    zero, stimecmph, %0"  
+                                  : /* output: none */ 
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and clear bits for stimecmph */
+            static uint32_t read_clr_bits(uint_csr32_t mask) {
+                uint_csr32_t value;
+                __asm__ volatile ("csrrc    %0, stimecmph, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+        
+            // ------------------------------------------
+            // Immediate value CSR bit set and clear instructions (only up to 5 bits)
+        
+            /** Atomic modify and set bits from immediate for stimecmph */
+            static void set_bits_imm(const uint8_t mask) {
+                __asm__ volatile ("csrrsi    zero, stimecmph, %0"  
+                                  : /* output: none */ 
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and set bits from immediate for stimecmph */
+            static uint32_t read_set_bits_imm(const uint8_t mask) {
+                uint_csr32_t value;
+                __asm__ volatile ("csrrsi    %0, stimecmph, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            /** Atomic modify and clear bits from immediate for stimecmph */
+            static void clr_bits_imm(const uint8_t mask) {
+                __asm__ volatile ("csrrci    zero, stimecmph, %0"  
+                                  : /* output: none */ 
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and clear bits from immediate for stimecmph */
+            static uint32_t read_clr_bits_imm(const uint8_t mask) {
+                uint_csr32_t value;
+                __asm__ volatile ("csrrci    %0, stimecmph, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            
+        }; /* stimecmph_ops */
+
+        // ----------------------------------------------------------------
+        // menvcfg - MRW - Machine Environment Configuration 
+        //
+        /** Machine Environment Configuration assembler operations */
+        struct menvcfg_ops  {
+            using datatype = uint_csr64_t;
+            static constexpr priv_t priv = MRW; 
+            
+            /** Read menvcfg */
+            static uint64_t read(void) {
+                uint_csr64_t value;        
+                __asm__ volatile ("csrr    %0, menvcfg" 
+                                  : "=r" (value)  /* output : register */
+                                  : /* input : none */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            
+            
+            /** Write menvcfg */
+            static void write(uint_csr64_t value) {
+                __asm__ volatile ("csrw    menvcfg, %0" 
+                                  : /* output: none */ 
+                                  : "r" (value) /* input : from register */
+                                  : /* clobbers: none */);
+            }
+            /** Write immediate value to menvcfg */
+            static void write_imm(uint_csr64_t value) {
+                __asm__ volatile ("csrwi    menvcfg, %0" 
+                                  : /* output: none */ 
+                                  : "i" (value) /* input : from immediate */
+                                  : /* clobbers: none */);
+            }
+            /** Read and then write to menvcfg */
+            static uint64_t read_write(uint_csr64_t new_value) {
+                uint_csr64_t prev_value;
+                __asm__ volatile ("csrrw    %0, menvcfg, %1"  
+                                  : "=r" (prev_value) /* output: register %0 */
+                                  : "r" (new_value)  /* input : register */
+                                  : /* clobbers: none */);
+                return prev_value;
+            }
+            /** Read and then write immediate value to menvcfg */
+            static uint64_t read_write_imm(const uint8_t new_value) {
+                uint_csr64_t prev_value;
+                __asm__ volatile ("csrrwi    %0, menvcfg, %1"  
+                                  : "=r" (prev_value) /* output: register %0 */
+                                  : "i" (new_value)  /* input : register */
+                                  : /* clobbers: none */);
+                return prev_value;
+            }
+        
+            // ------------------------------------------
+            // Register CSR bit set and clear instructions
+
+            /** Atomic modify and set bits for menvcfg */
+            static void set_bits(uint_csr64_t mask) {
+                __asm__ volatile ("csrrs    zero, menvcfg, %0"  
+                                  : /* output: none */ 
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and set bits for menvcfg */
+            static uint32_t read_set_bits(uint_csr64_t mask) {
+                uint_csr64_t value;
+                __asm__ volatile ("csrrs    %0, menvcfg, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            /** Atomic modify and clear bits for menvcfg */
+            static void clr_bits(uint_csr64_t mask) {
+                __asm__ volatile ("csrrc    zero, menvcfg, %0"  
+                                  : /* output: none */ 
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and clear bits for menvcfg */
+            static uint32_t read_clr_bits(uint_csr64_t mask) {
+                uint_csr64_t value;
+                __asm__ volatile ("csrrc    %0, menvcfg, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+        
+            // ------------------------------------------
+            // Immediate value CSR bit set and clear instructions (only up to 5 bits)
+        
+            /** Atomic modify and set bits from immediate for menvcfg */
+            static void set_bits_imm(const uint8_t mask) {
+                __asm__ volatile ("csrrsi    zero, menvcfg, %0"  
+                                  : /* output: none */ 
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and set bits from immediate for menvcfg */
+            static uint64_t read_set_bits_imm(const uint8_t mask) {
+                uint_csr64_t value;
+                __asm__ volatile ("csrrsi    %0, menvcfg, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            /** Atomic modify and clear bits from immediate for menvcfg */
+            static void clr_bits_imm(const uint8_t mask) {
+                __asm__ volatile ("csrrci    zero, menvcfg, %0"  
+                                  : /* output: none */ 
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and clear bits from immediate for menvcfg */
+            static uint64_t read_clr_bits_imm(const uint8_t mask) {
+                uint_csr64_t value;
+                __asm__ volatile ("csrrci    %0, menvcfg, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            
+        }; /* menvcfg_ops */
+        /** Parameter data for fields in menvcfg */
+        namespace menvcfg_data {
+#if __riscv_xlen==64
+            /** Parameter data for stce */
+            struct stce {
+                using datatype = uint_xlen_t;
+                static constexpr uint_csr64_t BIT_OFFSET = 63;
+                static constexpr uint_csr64_t BIT_WIDTH  = 1;
+                static constexpr uint_csr64_t BIT_MASK   = 0x8000000000000000;
+                static constexpr uint_csr64_t ALL_SET_MASK = 0x1;
+            };
+#endif
+        } /* menvcfg_data */
+
+        // ----------------------------------------------------------------
+        // menvcfgh - MRW - Upper 32 bits of  menvcfg, RV32 only. 
+        //
+        /** Upper 32 bits of  menvcfg, RV32 only. assembler operations */
+        struct menvcfgh_ops  {
+            using datatype = uint_csr32_t;
+            static constexpr priv_t priv = MRW; 
+            
+            /** Read menvcfgh */
+            static uint32_t read(void) {
+                uint_csr32_t value;        
+                __asm__ volatile ("csrr    %0, menvcfgh" 
+                                  : "=r" (value)  /* output : register */
+                                  : /* input : none */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            
+            
+            /** Write menvcfgh */
+            static void write(uint_csr32_t value) {
+                __asm__ volatile ("csrw    menvcfgh, %0" 
+                                  : /* output: none */ 
+                                  : "r" (value) /* input : from register */
+                                  : /* clobbers: none */);
+            }
+            /** Write immediate value to menvcfgh */
+            static void write_imm(uint_csr32_t value) {
+                __asm__ volatile ("csrwi    menvcfgh, %0" 
+                                  : /* output: none */ 
+                                  : "i" (value) /* input : from immediate */
+                                  : /* clobbers: none */);
+            }
+            /** Read and then write to menvcfgh */
+            static uint32_t read_write(uint_csr32_t new_value) {
+                uint_csr32_t prev_value;
+                __asm__ volatile ("csrrw    %0, menvcfgh, %1"  
+                                  : "=r" (prev_value) /* output: register %0 */
+                                  : "r" (new_value)  /* input : register */
+                                  : /* clobbers: none */);
+                return prev_value;
+            }
+            /** Read and then write immediate value to menvcfgh */
+            static uint32_t read_write_imm(const uint8_t new_value) {
+                uint_csr32_t prev_value;
+                __asm__ volatile ("csrrwi    %0, menvcfgh, %1"  
+                                  : "=r" (prev_value) /* output: register %0 */
+                                  : "i" (new_value)  /* input : register */
+                                  : /* clobbers: none */);
+                return prev_value;
+            }
+        
+            // ------------------------------------------
+            // Register CSR bit set and clear instructions
+
+            /** Atomic modify and set bits for menvcfgh */
+            static void set_bits(uint_csr32_t mask) {
+                __asm__ volatile ("csrrs    zero, menvcfgh, %0"  
+                                  : /* output: none */ 
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and set bits for menvcfgh */
+            static uint32_t read_set_bits(uint_csr32_t mask) {
+                uint_csr32_t value;
+                __asm__ volatile ("csrrs    %0, menvcfgh, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            /** Atomic modify and clear bits for menvcfgh */
+            static void clr_bits(uint_csr32_t mask) {
+                __asm__ volatile ("csrrc    zero, menvcfgh, %0"  
+                                  : /* output: none */ 
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and clear bits for menvcfgh */
+            static uint32_t read_clr_bits(uint_csr32_t mask) {
+                uint_csr32_t value;
+                __asm__ volatile ("csrrc    %0, menvcfgh, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "r" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+        
+            // ------------------------------------------
+            // Immediate value CSR bit set and clear instructions (only up to 5 bits)
+        
+            /** Atomic modify and set bits from immediate for menvcfgh */
+            static void set_bits_imm(const uint8_t mask) {
+                __asm__ volatile ("csrrsi    zero, menvcfgh, %0"  
+                                  : /* output: none */ 
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and set bits from immediate for menvcfgh */
+            static uint32_t read_set_bits_imm(const uint8_t mask) {
+                uint_csr32_t value;
+                __asm__ volatile ("csrrsi    %0, menvcfgh, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            /** Atomic modify and clear bits from immediate for menvcfgh */
+            static void clr_bits_imm(const uint8_t mask) {
+                __asm__ volatile ("csrrci    zero, menvcfgh, %0"  
+                                  : /* output: none */ 
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+            }
+            /** Atomic read and then and clear bits from immediate for menvcfgh */
+            static uint32_t read_clr_bits_imm(const uint8_t mask) {
+                uint_csr32_t value;
+                __asm__ volatile ("csrrci    %0, menvcfgh, %1"  
+                                  : "=r" (value) /* output: register %0 */
+                                  : "i" (mask)  /* input : register */
+                                  : /* clobbers: none */);
+                return value;
+            }
+            
+        }; /* menvcfgh_ops */
+        /** Parameter data for fields in menvcfgh */
+        namespace menvcfgh_data {
+            /** Parameter data for stce */
+            struct stce {
+                using datatype = uint_xlen_t;
+                static constexpr uint_csr32_t BIT_OFFSET = 31;
+                static constexpr uint_csr32_t BIT_WIDTH  = 1;
+                static constexpr uint_csr32_t BIT_MASK   = 0x80000000;
+                static constexpr uint_csr32_t ALL_SET_MASK = 0x1;
+            };
+        } /* menvcfgh_data */
     } /* csr */
 } /* riscv */
 
@@ -13107,6 +13659,9 @@ namespace riscv {
                 read_write_field<OPS, riscv::csr::mstatus_data::mprv> mprv;
                 read_write_field<OPS, riscv::csr::mstatus_data::mpp> mpp;
                 read_write_field<OPS, riscv::csr::mstatus_data::spp> spp;
+                read_write_field<OPS, riscv::csr::mstatus_data::fs> fs;
+                read_only_field<OPS, riscv::csr::mstatus_data::xs> xs;
+                read_only_field<OPS, riscv::csr::mstatus_data::sd> sd;
         };
         using mstatus = mstatus_reg<riscv::csr::mstatus_ops>;
         /* Additional machine status register, RV32 only. */
@@ -13712,6 +14267,32 @@ namespace riscv {
         {
         };
         using mtval2 = mtval2_reg<riscv::csr::mtval2_ops>;
+        /* Supervisor Timer Compare (Sstc) */
+        template<class OPS> class stimecmp_reg : public read_write_reg<OPS>
+        {
+        };
+        using stimecmp = stimecmp_reg<riscv::csr::stimecmp_ops>;
+        /* Upper 32 bits of  stimecmp, RV32 only. */
+        template<class OPS> class stimecmph_reg : public read_write_reg<OPS>
+        {
+        };
+        using stimecmph = stimecmph_reg<riscv::csr::stimecmph_ops>;
+        /* Machine Environment Configuration */
+        template<class OPS> class menvcfg_reg : public read_write_reg<OPS>
+        {
+#if __riscv_xlen==64
+            public:
+                read_write_field<OPS, riscv::csr::menvcfg_data::stce> stce;
+#endif
+        };
+        using menvcfg = menvcfg_reg<riscv::csr::menvcfg_ops>;
+        /* Upper 32 bits of  menvcfg, RV32 only. */
+        template<class OPS> class menvcfgh_reg : public read_write_reg<OPS>
+        {
+            public:
+                read_write_field<OPS, riscv::csr::menvcfgh_data::stce> stce;
+        };
+        using menvcfgh = menvcfgh_reg<riscv::csr::menvcfgh_ops>;
 
         /** Encapsulate all CSRs in a single structure.
            - No storage is required by this class.
@@ -13939,6 +14520,14 @@ namespace riscv {
             riscv::csr::mtinst mtinst;
             /* Machine bad guest physical address. */
             riscv::csr::mtval2 mtval2;
+            /* Supervisor Timer Compare (Sstc) */
+            riscv::csr::stimecmp stimecmp;
+            /* Upper 32 bits of  stimecmp, RV32 only. */
+            riscv::csr::stimecmph stimecmph;
+            /* Machine Environment Configuration */
+            riscv::csr::menvcfg menvcfg;
+            /* Upper 32 bits of  menvcfg, RV32 only. */
+            riscv::csr::menvcfgh menvcfgh;
         };
 
     } /* csr */
@@ -22,8 +22,36 @@ namespace riscv {
         static constexpr std::uint32_t usi = 0;
         static constexpr std::uint32_t uti = 4;
         static constexpr std::uint32_t uei = 8;
+
+        /** Cause of the highest priority interrupt in a pending mask, e.g. (mip & mie).
+            Priority is mei, msi, mti, sei, ssi, sti, then the lowest numbered interrupt.
+            @param pending Non zero mask of pending interrupts.
+         */
+        static constexpr std::uint32_t next_pending(std::uintptr_t pending) {
+            constexpr std::uint32_t priority[] = {mei, msi, mti, sei, ssi, sti};
+            for (auto cause : priority) {
+                if (pending & (static_cast<std::uintptr_t>(1) << cause)) {
+                    return cause;
+                }
+            }
+            return __builtin_ctzl(pending);
+        }
     };/*interrupts*/
     struct exceptions {
+        static constexpr std::uint32_t instruction_address_misaligned = 0;
+        static constexpr std::uint32_t instruction_access_fault = 1;
+        static constexpr std::uint32_t illegal_instruction = 2;
+        static constexpr std::uint32_t breakpoint = 3;
+        static constexpr std::uint32_t load_address_misaligned = 4;
+        static constexpr std::uint32_t load_access_fault = 5;
+        static constexpr std::uint32_t store_amo_address_misaligned = 6;
+        static constexpr std::uint32_t store_amo_access_fault = 7;
+        static constexpr std::uint32_t environment_call_from_u_mode = 8;
+        static constexpr std::uint32_t environment_call_from_s_mode = 9;
+        static constexpr std::uint32_t environment_call_from_m_mode = 11;
+        static constexpr std::uint32_t instruction_page_fault = 12;
+        static constexpr std::uint32_t load_page_fault = 13;
+        static constexpr std::uint32_t store_amo_page_fault = 15;
     };/*exceptions*/
 } /* riscv */
 
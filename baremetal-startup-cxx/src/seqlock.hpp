@@ -0,0 +1,98 @@
+/*
+   Sequence lock for state shared between interrupt handlers and the main program.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <cstdint>
+#include <type_traits>
+
+namespace riscv {
+
+    /** Value written by interrupt handlers and read as a consistent snapshot by the main program,
+        without disabling interrupts.
+
+        The writer increments the sequence before and after the update, it never waits.
+        The reader copies the value and retries if the sequence was odd or changed during the copy.
+        On RV32 this gives a tear free read of a uint64_t or a struct of several counters.
+
+        Writers and readers must be on the same hart, a compiler barrier orders the accesses.
+        Nested writers are allowed, they complete before the main program resumes.
+        Do not read from an interrupt handler that may preempt a writer, use try_read().
+
+        The value is placed first so a trace of the symbol shows the value.
+
+        Usage:
+            static riscv::seqlock<std::uint64_t> timestamp;
+            // Interrupt handler
+            timestamp.write(mtimer.get_time<driver::timer<>::timer_ticks>().count());
+            // Main program
+            auto now = timestamp.read();
+
+        @tparam T Trivially copyable value type.
+     */
+    template<class T>
+    class seqlock {
+    public:
+        static_assert(std::is_trivially_copyable<T>::value, "seqlock value must be trivially copyable");
+
+        /** Replace the value. Call from the writer (interrupt handler). */
+        void write(const T &value) {
+            update([&value](T &v) { v = value; });
+        }
+
+        /** Modify the value in place, e.g. increment a counter. Call from the writer (interrupt handler).
+            @param f Called with a reference to the value.
+         */
+        template<class F> void update(F f) {
+            sequence_ = sequence_ + 1;
+            barrier();
+            f(value_);
+            barrier();
+            sequence_ = sequence_ + 1;
+        }
+
+        /** Consistent snapshot of the value, retried until no write overlapped the copy. */
+        T read(void) const {
+            T value;
+            while (!try_read(value)) {
+            }
+            return value;
+        }
+
+        /** Single attempt to take a snapshot.
+            @return false if a write is in progress or overlapped the copy.
+         */
+        bool try_read(T &value) const {
+            std::uint32_t start = sequence_;
+            if (start & 1) {
+                return false;
+            }
+            barrier();
+            value = value_;
+            barrier();
+            return start == sequence_;
+        }
+
+        /** Number of completed writes */
+        std::uint32_t writes(void) const {
+            return sequence_ >> 1;
+        }
+
+    private:
+        static inline void barrier(void) {
+            __asm__ volatile ("" : : : "memory");
+        }
+
+        T value_{};
+        volatile std::uint32_t sequence_{0};
+    };
+
+} /* riscv */
+
+#endif // #ifdef SEQLOCK_HPP
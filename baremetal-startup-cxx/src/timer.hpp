@@ -9,8 +9,12 @@
 #ifndef TIMER_HPP
 #define TIMER_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <chrono>
+#include <type_traits>
+
+#include "riscv-csr.hpp"
 
 namespace driver {
 
@@ -30,15 +34,115 @@ namespace driver {
     / /
     */
     struct mtimer_address_spec {
+        static constexpr std::uintptr_t MSIP_ADDR = 0x2000000 + 0x0000;
         static constexpr std::uintptr_t MTIMECMP_ADDR = 0x2000000 + 0x4000;
         static constexpr std::uintptr_t MTIME_ADDR = 0x2000000 + 0xBFF8;
+        // Per-hart register stride of the standard CLINT layout
+        static constexpr std::uintptr_t MSIP_STRIDE = 4;
+        static constexpr std::uintptr_t MTIMECMP_STRIDE = 8;
+    };
+
+    /** Select the per-hart timer registers for a hart ID fixed at compile time.
+     */
+    template<std::size_t HART_ID> struct hart_id_fixed {
+        static constexpr std::size_t read(void) {
+            return HART_ID;
+        }
+    };
+
+    /** Select the per-hart timer registers of the calling hart, read from mhartid at runtime.
+     */
+    struct hart_id_runtime {
+        static std::size_t read(void) {
+            return riscv::csrs.mhartid.read();
+        }
+    };
+
+    /** Read the system time from the memory mapped mtime register at ADDRESS_SPEC::MTIME_ADDR.
+     */
+    struct mtime_source_mmio {};
+
+    /** Read the system time from the time/timeh CSRs (Zicntr, rdtime).
+        The core must implement the time CSR, on many cores this avoids a bus access.
+     */
+    struct mtime_source_csr {
+        /** Read the raw time of the system timer from the time/timeh CSRs
+         */
+        static uint64_t read(void) {
+            if constexpr ( __riscv_xlen == 64) {
+                // Directly read 64 bit value
+                return riscv::csrs.time.read();
+            } else {
+                std::uint32_t timeh_val;
+                std::uint32_t timel_val;
+                do {
+                    // There is a small risk the timeh will tick over after reading time
+                    timeh_val = riscv::csrs.timeh.read();
+                    timel_val = riscv::csrs.time.read();
+                    // Poll timeh to ensure it's consistent after reading time
+                } while (timeh_val != riscv::csrs.timeh.read());
+                return (static_cast<std::uint64_t>(timeh_val)<<32)|timel_val;
+            }
+        }
+    };
+
+    /** Default timer instrumentation, no latency statistics are recorded.
+     */
+    struct latency_stats_none {
+        static void programmed(std::uint64_t) {}
+        static void record(std::uint64_t) {}
+    };
+
+    /** Timer interrupt latency statistics.
+        The latency is the number of system timer clocks from mtimecmp to the handler entry, (mtime - mtimecmp).
+        The statistics are static members, inspect with a debugger.
+        @tparam BUCKETS Number of histogram buckets, the last bucket counts all larger latencies.
+        @tparam BUCKET_SHIFT Each histogram bucket covers (1<<BUCKET_SHIFT) system timer clocks.
+     */
+    template<std::size_t BUCKETS=16, unsigned int BUCKET_SHIFT=0>
+    struct latency_stats {
+        /** Compare value last programmed by set_raw_time_cmp() */
+        static inline volatile std::uint64_t mtimecmp{0};
+        /** Number of recorded interrupts */
+        static inline volatile std::uint32_t count{0};
+        /** Latency in system timer clocks */
+        static inline volatile std::uint32_t min_ticks{0};
+        static inline volatile std::uint32_t max_ticks{0};
+        /** Histogram of the latency in system timer clocks */
+        static inline volatile std::uint32_t histogram[BUCKETS]{};
+
+        /** Remember a newly programmed compare value */
+        static void programmed(std::uint64_t new_mtimecmp) {
+            mtimecmp = new_mtimecmp;
+        }
+        /** Record the latency of an interrupt entered at entry_time */
+        static void record(std::uint64_t entry_time) {
+            std::uint64_t late_ticks = entry_time - mtimecmp;
+            std::uint32_t ticks = (late_ticks > UINT32_MAX) ? UINT32_MAX : static_cast<std::uint32_t>(late_ticks);
+            if (count == 0) {
+                min_ticks = max_ticks = ticks;
+            } else {
+                if (ticks < min_ticks) min_ticks = ticks;
+                if (ticks > max_ticks) max_ticks = ticks;
+            }
+            count = count + 1;
+            std::size_t bucket = ticks >> BUCKET_SHIFT;
+            if (bucket >= BUCKETS) {
+                bucket = BUCKETS - 1;
+            }
+            histogram[bucket] = histogram[bucket] + 1;
+        }
     };
 
     /** Simple TIMER driver class 
+        @tparam LATENCY_STATS Instrumentation, latency_stats_none or latency_stats<>.
      */
     template<class BASE_DURATION=std::chrono::microseconds,
              class ADDRESS_SPEC=mtimer_address_spec, 
-             class CONFIG=default_timer_config> class timer {
+             class CONFIG=default_timer_config,
+             class TIME_SOURCE=mtime_source_mmio,
+             class HART=hart_id_fixed<0>,
+             class LATENCY_STATS=latency_stats_none> class timer {
     public :
 
         /** Duration of each timer tick */
@@ -74,13 +178,14 @@ namespace driver {
         void set_raw_time_cmp(uint64_t clock_offset) {
             // First of all set 
             auto new_mtimecmp = get_raw_time() + clock_offset;
+            LATENCY_STATS::programmed(new_mtimecmp);
             if constexpr ( __riscv_xlen == 64) {
                 // Single bus access
-                auto mtimecmp = reinterpret_cast<volatile std::uint64_t *>(ADDRESS_SPEC::MTIMECMP_ADDR);
+                auto mtimecmp = reinterpret_cast<volatile std::uint64_t *>(mtimecmp_addr());
                 *mtimecmp = new_mtimecmp;
             } else {
-                auto mtimecmpl = reinterpret_cast<volatile std::uint32_t *>(ADDRESS_SPEC::MTIMECMP_ADDR);
-                auto mtimecmph = reinterpret_cast<volatile std::uint32_t *>(ADDRESS_SPEC::MTIMECMP_ADDR+4);
+                auto mtimecmpl = reinterpret_cast<volatile std::uint32_t *>(mtimecmp_addr());
+                auto mtimecmph = reinterpret_cast<volatile std::uint32_t *>(mtimecmp_addr()+4);
                 // AS we are doing 32 bit writes, an intermediate mtimecmp value may cause spurious interrupts.
                 // Prevent that by first setting the dummy MSB to an unacheivable value
                 *mtimecmph = 0xFFFFFFFF;  // cppcheck-suppress redundantAssignment
@@ -91,9 +196,52 @@ namespace driver {
             }
         }
 
+        /** Record the timer interrupt latency with LATENCY_STATS.
+            Call at the entry of the MTI handler, before the compare point is re-programmed.
+         */
+        void record_latency(void) {
+            LATENCY_STATS::record(get_raw_time());
+        }
+
+        /** Raise the machine software interrupt (MSI) of this hart.
+         */
+        void set_msip(void) {
+            set_hart_msip(HART::read());
+        }
+        /** Clear the machine software interrupt (MSI) of this hart.
+         */
+        void clr_msip(void) {
+            clr_hart_msip(HART::read());
+        }
+        /** Read the machine software interrupt (MSI) pending bit of this hart.
+         */
+        bool read_msip(void) {
+            return (*msip_addr(HART::read()) & 0x1) != 0;
+        }
+        /** Raise the machine software interrupt (MSI) of any hart, e.g. to signal another hart.
+         */
+        static void set_hart_msip(std::size_t hart_id) {
+            *msip_addr(hart_id) = 1;
+        }
+        /** Clear the machine software interrupt (MSI) of any hart.
+         */
+        static void clr_hart_msip(std::size_t hart_id) {
+            *msip_addr(hart_id) = 0;
+        }
+
         /** Read the raw time of the system timer in system timer clocks
          */
         uint64_t get_raw_time(void) {
+            if constexpr (std::is_same_v<TIME_SOURCE, mtime_source_csr>) {
+                return mtime_source_csr::read();
+            } else {
+                return get_raw_time_mmio();
+            }
+        }
+
+        /** Read the raw time of the system timer from the memory mapped mtime register
+         */
+        static uint64_t get_raw_time_mmio(void) {
             if constexpr ( __riscv_xlen == 64) {
                 // Directly read 64 bit value
                 auto mtime = reinterpret_cast<volatile std::uint64_t *>(ADDRESS_SPEC::MTIME_ADDR);
@@ -113,6 +261,71 @@ namespace driver {
                 return (static_cast<std::uint64_t>(mtimeh_val)<<32)|mtimel_val;
             } 
         }
+
+    private :
+        /** Address of the mtimecmp register of this hart */
+        static std::uintptr_t mtimecmp_addr(void) {
+            return ADDRESS_SPEC::MTIMECMP_ADDR + HART::read()*ADDRESS_SPEC::MTIMECMP_STRIDE;
+        }
+        /** Address of the msip register of a hart */
+        static volatile std::uint32_t *msip_addr(std::size_t hart_id) {
+            return reinterpret_cast<volatile std::uint32_t *>(ADDRESS_SPEC::MSIP_ADDR + hart_id*ADDRESS_SPEC::MSIP_STRIDE);
+        }
+    };
+
+    /** Supervisor mode TIMER driver class using the Sstc stimecmp CSR.
+        The supervisor timer interrupt (STI) is raised directly by stimecmp, 
+        without an M-mode MTI handler forwarding the interrupt to S-mode.
+        M-mode must set menvcfg.STCE and mcounteren.TM before this driver is used in S-mode.
+     */
+    template<class BASE_DURATION=std::chrono::microseconds,
+             class CONFIG=default_timer_config> class stimer {
+    public :
+
+        /** Duration of each timer tick */
+        using timer_ticks = std::chrono::duration<int, std::ratio<1, CONFIG::MTIME_FREQ_HZ>>;
+
+        /** Set the timer compare point using a std::chrono::duration timer offset 
+         */
+        template<class T=BASE_DURATION> void set_time_cmp(T time_offset) {
+            set_ticks_time_cmp(std::chrono::duration_cast<timer_ticks>(time_offset));
+        }
+        /** Get the system timer as a std::chrono::duration value 
+         */
+        template<class T=BASE_DURATION> T get_time(void) {
+            return std::chrono::duration_cast<T>(get_ticks_time());
+        }
+        /** Set the time compare point in ticks of the system timer counter.
+         */
+        void set_ticks_time_cmp(timer_ticks time_offset) {
+            set_raw_time_cmp(time_offset.count());
+        }
+        /** Return the current system time as a duration since the time counter was initialized 
+         */
+        timer_ticks get_ticks_time(void) {
+            return timer_ticks(get_raw_time());
+        }
+        /** Set the raw time compare point in system timer clocks.
+         * @param clock_offset Time relative to current time when 
+         * An interrupt will be generated at time + clock_offset.
+         */
+        void set_raw_time_cmp(uint64_t clock_offset) {
+            auto new_stimecmp = get_raw_time() + clock_offset;
+            if constexpr ( __riscv_xlen == 64) {
+                riscv::csrs.stimecmp.write(new_stimecmp);
+            } else {
+                // As with mtimecmp, prevent a spurious interrupt from an intermediate value
+                // by first setting the MSB to an unacheivable value
+                riscv::csrs.stimecmph.write(0xFFFFFFFF);
+                riscv::csrs.stimecmp.write(static_cast<uint32_t>(new_stimecmp & 0x0FFFFFFFFUL));
+                riscv::csrs.stimecmph.write(static_cast<uint32_t>(new_stimecmp >> 32));
+            }
+        }
+        /** Read the raw time of the system timer in system timer clocks
+         */
+        uint64_t get_raw_time(void) {
+            return mtime_source_csr::read();
+        }
     };
 
 }
@@ -0,0 +1,102 @@
+/*
+   Table driven trap entry for direct mode mtvec.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef TRAP_DISPATCH_HPP
+#define TRAP_DISPATCH_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#include "riscv-csr.hpp"
+
+namespace riscv {
+
+    /** Handler called by a trap dispatch table, a plain function. */
+    using dispatch_handler = void (*)(void);
+
+    /** Entry of a dispatch table, the handler of a cause.
+        @tparam CAUSE Interrupt or exception cause, e.g. riscv::interrupts::mti
+        @tparam HANDLER Plain function, not an interrupt ("machine") function.
+     */
+    template<std::uint32_t CAUSE, dispatch_handler HANDLER>
+    struct dispatch_vector {
+        static constexpr std::uint32_t cause = CAUSE;
+        static constexpr dispatch_handler handler = HANDLER;
+    };
+
+    /** Table of handlers indexed by cause, generated at compile time.
+        Causes that are not listed call DEFAULT_HANDLER.
+        The cause is masked to the table size, so there is no bounds check branch.
+        @tparam ENTRIES Number of causes, a power of 2.
+     */
+    template<std::size_t ENTRIES, dispatch_handler DEFAULT_HANDLER, class... VECTORS>
+    struct dispatch_table {
+        static_assert((ENTRIES & (ENTRIES - 1)) == 0, "Dispatch table size must be a power of 2");
+        static_assert(((VECTORS::cause < ENTRIES) && ...), "Cause is outside the dispatch table");
+
+        static constexpr std::uintptr_t MASK = ENTRIES - 1;
+        /** Bit set for each cause with a listed handler, e.g. to select from mip */
+        static constexpr std::uintptr_t HANDLED = (static_cast<std::uintptr_t>(0) | ... | (static_cast<std::uintptr_t>(1) << VECTORS::cause));
+
+        struct handlers_t {
+            dispatch_handler handler[ENTRIES];
+        };
+        static constexpr handlers_t make(void) {
+            handlers_t t{};
+            for (std::size_t i = 0; i < ENTRIES; i++) {
+                t.handler[i] = DEFAULT_HANDLER;
+            }
+            ((t.handler[VECTORS::cause] = VECTORS::handler), ...);
+            return t;
+        }
+        static constexpr handlers_t handlers = make();
+
+        /** Call the handler of a cause */
+        static void dispatch(std::uintptr_t cause) {
+            handlers.handler[cause & MASK]();
+        }
+    };
+
+    /** Direct mode trap entry. Reads mcause, selects the interrupt or
+        exception table with the sign bit and calls the handler. There is
+        no switch or search, every cause has the same dispatch cost.
+
+        Usage:
+            using interrupts = riscv::dispatch_table<16, nop,
+                                                     riscv::dispatch_vector<riscv::interrupts::mti, mti_handler>>;
+            using exceptions = riscv::dispatch_table<16, nop>;
+            using trap = riscv::trap_dispatch<interrupts, exceptions>;
+            riscv::csrs.mtvec.write(reinterpret_cast<std::uintptr_t>(trap::entry));
+
+        @tparam INTERRUPTS riscv::dispatch_table of interrupt handlers.
+        @tparam EXCEPTIONS riscv::dispatch_table of exception handlers.
+     */
+    template<class INTERRUPTS, class EXCEPTIONS>
+    struct trap_dispatch {
+        /** Dispatch a cause read from mcause */
+        static void dispatch(std::uintptr_t cause) {
+            // mcause.Interrupt is the sign bit
+            if (static_cast<std::intptr_t>(cause) < 0) {
+                INTERRUPTS::dispatch(cause);
+            } else {
+                EXCEPTIONS::dispatch(cause);
+            }
+        }
+
+        /** Trap entry, the value for mtvec in direct mode. */
+        static void entry(void) __attribute__ ((interrupt ("machine"), aligned(4)));
+    };
+
+    template<class INTERRUPTS, class EXCEPTIONS>
+    void trap_dispatch<INTERRUPTS, EXCEPTIONS>::entry(void) {
+        dispatch(riscv::csrs.mcause.read());
+    }
+
+} /* riscv */
+
+#endif // #ifdef TRAP_DISPATCH_HPP
@@ -0,0 +1,111 @@
+/*
+   Compile time generated vectored mode trap table.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef VECTOR_TABLE_HPP
+#define VECTOR_TABLE_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+namespace riscv {
+
+    /** Trap handler function, declared with __attribute__ ((interrupt ("machine"))) */
+    using trap_handler = void (*)(void);
+
+    /** Vector table slot of synchronous exceptions.
+        When vectored interrupts are enabled synchronous exceptions enter at the same slot as cause 0 (usi).
+     */
+    static constexpr std::uint32_t exception_vector = 0;
+
+    /** Entry of a vector table, the handler to jump to for an interrupt cause.
+        @tparam CAUSE Interrupt cause, e.g. riscv::interrupts::mti
+        @tparam HANDLER Interrupt handler, must be an interrupt ("machine") function.
+     */
+    template<std::uint32_t CAUSE, trap_handler HANDLER>
+    struct vector {
+        static constexpr std::uint32_t cause = CAUSE;
+        static constexpr trap_handler handler = HANDLER;
+    };
+
+    /** Vectored mode mtvec table, generated at compile time from a list of riscv::vector entries.
+        Each slot is a single "jal zero,handler" instruction, causes that are not listed jump to DEFAULT_HANDLER.
+
+        Use riscv::vector<riscv::exception_vector, handler> to handle synchronous exceptions.
+
+        Usage:
+            using table = riscv::mtvec_table<default_handler,
+                                             riscv::vector<riscv::interrupts::mti, mti_handler>>;
+            riscv::csrs.mtvec.write(table::mtvec());
+
+        @tparam DEFAULT_HANDLER Handler for all causes not in VECTORS.
+        @tparam VECTORS riscv::vector entries.
+     */
+    template<trap_handler DEFAULT_HANDLER, class... VECTORS>
+    struct mtvec_table {
+        /** Number of slots, the standard local interrupts */
+        static constexpr std::size_t ENTRIES = 16;
+        /** Value of mtvec.MODE for vectored mode */
+        static constexpr std::uintptr_t MODE_VECTORED = 1;
+
+        static_assert(((VECTORS::cause < ENTRIES) && ...), "Interrupt cause is outside the vector table");
+
+        /** Handler for an interrupt cause, selected at compile time */
+        template<std::uint32_t CAUSE> static constexpr trap_handler handler(void) {
+            trap_handler selected = DEFAULT_HANDLER;
+            ((selected = (VECTORS::cause == CAUSE) ? VECTORS::handler : selected), ...);
+            return selected;
+        }
+
+        /** Value to write to mtvec, the table address with the mode set to vectored */
+        static std::uintptr_t mtvec(void) {
+            return reinterpret_cast<std::uintptr_t>(table) | MODE_VECTORED;
+        }
+
+        /** Vector table. Do not call!
+            The bottom 2 bits of mtvec are the mode - so align to at least 4 bytes.
+            Some cores require greater alignment, use the same alignment as vector_table.c
+         */
+        static void table(void) __attribute__ ((naked, aligned(256)));
+    };
+
+    template<trap_handler DEFAULT_HANDLER, class... VECTORS>
+    void mtvec_table<DEFAULT_HANDLER, VECTORS...>::table(void) {
+        // Disable compressed instructions, each slot must be exactly 4 bytes.
+        __asm__ volatile (
+            ".option push;"
+            ".option norvc;"
+            "jal zero,%0;"    /* 0  */
+            "jal zero,%1;"    /* 1  */
+            "jal zero,%2;"    /* 2  */
+            "jal zero,%3;"    /* 3  */
+            "jal zero,%4;"    /* 4  */
+            "jal zero,%5;"    /* 5  */
+            "jal zero,%6;"    /* 6  */
+            "jal zero,%7;"    /* 7  */
+            "jal zero,%8;"    /* 8  */
+            "jal zero,%9;"    /* 9  */
+            "jal zero,%10;"   /* 10 */
+            "jal zero,%11;"   /* 11 */
+            "jal zero,%12;"   /* 12 */
+            "jal zero,%13;"   /* 13 */
+            "jal zero,%14;"   /* 14 */
+            "jal zero,%15;"   /* 15 */
+            ".option pop;"
+            : /* output: none */
+            : /* input : immediate */
+              "i"(handler<0>()),  "i"(handler<1>()),  "i"(handler<2>()),  "i"(handler<3>()),
+              "i"(handler<4>()),  "i"(handler<5>()),  "i"(handler<6>()),  "i"(handler<7>()),
+              "i"(handler<8>()),  "i"(handler<9>()),  "i"(handler<10>()), "i"(handler<11>()),
+              "i"(handler<12>()), "i"(handler<13>()), "i"(handler<14>()), "i"(handler<15>())
+            : /* clobbers: none */
+            );
+    }
+
+} /* riscv */
+
+#endif // #ifdef VECTOR_TABLE_HPP
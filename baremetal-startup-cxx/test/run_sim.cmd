@@ -15,6 +15,8 @@ trace _ZL26global_u8c_value_with_init
 trace _ZL26global_u8d_value_with_init
 trace _ZL30global_value1_with_constructor
 trace _ZL30global_value2_with_constructor
+trace _ZL16stack_usage_main
+trace _ZL15stack_usage_isr
 
 
 until pc 0 main
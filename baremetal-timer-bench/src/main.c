@@ -0,0 +1,59 @@
+/*
+   Baremetal microbenchmark of the system timer read backends.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   Compares reading mtime over the memory mapped bus against reading
+   the time/timeh CSRs with rdtime.
+
+*/
+
+#include <stdint.h>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.h"
+#include "timer.h"
+
+// Number of timer reads per measurement
+#define BENCH_ITERATIONS 64
+
+// Measure the mcycle delta of BENCH_ITERATIONS evaluations of EXPR
+#define BENCH_CYCLES(RESULT, EXPR)                             \
+    do {                                                       \
+        uint_xlen_t start_cycle = csr_read_mcycle();           \
+        for (unsigned int i = 0; i < BENCH_ITERATIONS; i++) {  \
+            last_time = (EXPR);                                \
+        }                                                      \
+        RESULT = csr_read_mcycle() - start_cycle;              \
+    } while (0)
+
+// Sink for the timer reads, so they are not optimized away.
+static volatile uint64_t last_time = 0;
+
+// Results in cycles, for BENCH_ITERATIONS reads. Traced by test/run_sim.cmd
+static volatile uint_xlen_t loop_cycles = 0;
+static volatile uint_xlen_t mmio_cycles = 0;
+static volatile uint_xlen_t csr_cycles = 0;
+// Count of completed measurement runs
+static volatile uint32_t bench_count = 0;
+
+int main(void) {
+    // Global interrupt disable, measure without interruption
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    csr_write_mie(0);
+
+    do {
+        // Loop overhead only, subtract from the results below
+        BENCH_CYCLES(loop_cycles, 0);
+        // Both backends are static inline in timer.h, so the loops differ only in the timer read.
+        // Memory mapped mtime, includes the RV32 mtimeh retry loop
+        BENCH_CYCLES(mmio_cycles, mtimer_get_raw_time_mmio());
+        // time/timeh CSRs, includes the RV32 timeh retry loop
+        BENCH_CYCLES(csr_cycles, mtimer_get_raw_time_csr());
+        bench_count++;
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
@@ -15,6 +15,7 @@
 #include "timer.h"
 
 #include "vector_table.h"
+#include "seqlock.h"
 
 // Machine mode interrupt service routine
 
@@ -31,6 +32,19 @@ static volatile uint32_t mti_count = 0;
 static volatile uint32_t msi_count = 0;
 static volatile uint32_t mei_count = 0;
 
+// Protects timestamp, ecall_count and the interrupt counters written by the handlers
+static seqlock_t irq_seq = 0;
+
+// Consistent copy of the values written by the handlers, taken by main() after each wakeup.
+struct irq_snapshot {
+    uint64_t timestamp;
+    uint64_t ecall_count;
+    uint32_t mti_count;
+    uint32_t msi_count;
+    uint32_t mei_count;
+};
+static volatile struct irq_snapshot snapshot;
+
 #define RISCV_MTVEC_MODE_VECTORED 1
 
 int main(void) {
@@ -63,6 +77,17 @@ int main(void) {
 
         wakeup_count ++;
 
+        // Read the values as a set, retry if an interrupt updated them during the copy.
+        struct irq_snapshot copy;
+        SEQLOCK_READ(irq_seq, {
+            copy.timestamp = timestamp;
+            copy.ecall_count = ecall_count;
+            copy.mti_count = mti_count;
+            copy.msi_count = msi_count;
+            copy.mei_count = mei_count;
+        });
+        snapshot = copy;
+
         // Try a synchronous exception.
         __asm__ volatile ("ecall");
 
@@ -79,10 +104,14 @@ int main(void) {
 #pragma GCC optimize ("align-functions=4")
 // The 'riscv_mtvec_mti' function is added to the vector table by the vector_table.c
 void riscv_mtvec_mti(void)  {
-    mti_count++;
+    // Latency from mtimecmp to here, when built with MTIMER_LATENCY_STATS
+    MTIMER_RECORD_LATENCY();
     // Timer exception, re-program the timer for a 1 micro-second tick.
     mtimer_set_raw_time_cmp(MTIMER_USEC_TO_CLOCKS(1));
-    timestamp = mtimer_get_raw_time();
+    SEQLOCK_WRITE(irq_seq, {
+        mti_count++;
+        timestamp = mtimer_get_raw_time();
+    });
 }
 // The 'riscv_mtvec_exception' function is added to the vector table by the vector_table.c
 // This function looks at the cause of the exception, if it is an 'ecall' instruction then increment a global counter.
@@ -92,7 +121,7 @@ void riscv_mtvec_exception(void)  {
     //uint_xlen_t this_value = csr_read_mtval();
     switch (this_cause) {
         case RISCV_EXCP_ENVIRONMENT_CALL_FROM_M_MODE:
-            ecall_count++;
+            SEQLOCK_WRITE(irq_seq, ecall_count++);
             // Make sure the return address is the instruction AFTER ecall
             csr_write_mepc(this_pc+4);
             break;
@@ -102,11 +131,11 @@ void riscv_mtvec_exception(void)  {
 
 // Machine mode software interrupt
 void riscv_mtvec_msi(void) {
-    msi_count++;
+    SEQLOCK_WRITE(irq_seq, msi_count++);
 }
 // Machine mode external interrupt 
 void riscv_mtvec_mei(void) {
-    mei_count++;
+    SEQLOCK_WRITE(irq_seq, mei_count++);
 }
 
 
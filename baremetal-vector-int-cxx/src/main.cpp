@@ -0,0 +1,111 @@
+/*
+   Baremetal main program with a compile time generated vector table.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   C++ version of baremetal-vector-int. The mtvec table is generated by
+   riscv::mtvec_table from the list of handlers.
+
+*/
+
+#include <cstdint>
+#include <chrono>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.hpp"
+#include "riscv-interrupts.hpp"
+#include "timer.hpp"
+#include "vector_table.hpp"
+#include "critical_section.hpp"
+
+// From riscv-isa-sim/riscv/sim.h, the HiFive board uses driver::default_timer_config
+struct sim_timer_config {
+    static constexpr unsigned int MTIME_FREQ_HZ=10000000;
+};
+
+// Timer driver
+static driver::timer<std::chrono::microseconds, driver::mtimer_address_spec, sim_timer_config> mtimer;
+
+// Machine mode trap handlers
+static void mti_handler(void) __attribute__ ((interrupt ("machine")));
+static void exception_handler(void) __attribute__ ((interrupt ("machine")));
+static void default_handler(void) __attribute__ ((interrupt ("machine")));
+
+// The vector table. Slot 0 is shared by synchronous exceptions.
+using trap_table = riscv::mtvec_table<default_handler,
+                                      riscv::vector<riscv::interrupts::mti, mti_handler>,
+                                      riscv::vector<riscv::exception_vector, exception_handler>>;
+
+// Global to hold current timestamp, written in MTI handler.
+static volatile uint64_t timestamp{0};
+// Count each timer interrupt
+static volatile uint32_t mti_count{0};
+// Expect this to increment after each return of MTI handler.
+static volatile uint32_t ecall_count{0};
+// Count unexpected traps
+static volatile uint32_t default_count{0};
+// Copy of timestamp and mti_count taken together by main()
+static volatile uint64_t main_timestamp{0};
+static volatile uint32_t main_mti_count{0};
+
+int main(void) {
+    {
+        // Global interrupt disable, restored to the reset state at the end of the scope
+        riscv::critical_section guard;
+        riscv::csrs.mie.write(0);
+
+        // Setup the IRQ handler entry point, set the mode to vectored
+        riscv::csrs.mtvec.write(trap_table::mtvec());
+
+        // Setup timer for 1 millisecond interval
+        timestamp = mtimer.get_raw_time();
+        mtimer.set_time_cmp(std::chrono::milliseconds{1});
+
+        // Timer interrupt enable
+        riscv::csrs.mie.mti.set();
+    }
+    // Global interrupt enable
+    riscv::csrs.mstatus.mie.set();
+
+    // Busy loop
+    do {
+        // Wait for timer interrupt
+        __asm__ volatile ("wfi");
+        {
+            // Only the timer interrupt writes these, other interrupts are not delayed.
+            riscv::mask_guard<riscv::csr::mie_data::mti> guard;
+            main_timestamp = timestamp;
+            main_mti_count = mti_count;
+        }
+        // Try a synchronous exception.
+        __asm__ volatile ("ecall");
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+static void mti_handler(void) {
+    mti_count++;
+    // Timer exception, re-program the timer for a one millisecond tick.
+    mtimer.set_time_cmp(std::chrono::milliseconds{1});
+    timestamp = mtimer.get_raw_time();
+}
+// This function looks at the cause of the exception, if it is an 'ecall' instruction then increment a global counter.
+static void exception_handler(void) {
+    auto this_cause = riscv::csrs.mcause.read();
+    auto this_pc = riscv::csrs.mepc.read();
+    if (this_cause == riscv::exceptions::environment_call_from_m_mode) {
+        ecall_count++;
+        // Make sure the return address is the instruction AFTER ecall
+        riscv::csrs.mepc.write(this_pc+4);
+    }
+}
+static void default_handler(void) {
+    default_count++;
+}
+#pragma GCC pop_options
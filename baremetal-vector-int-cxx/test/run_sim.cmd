@@ -0,0 +1,18 @@
+echo on
+
+until pc 0 main
+pc 0
+
+run 100000
+mem _ZL9timestamp
+mem _ZL9mti_count
+mem _ZL11ecall_count
+mem _ZL13default_count
+
+run 100000
+mem _ZL9timestamp
+mem _ZL9mti_count
+mem _ZL11ecall_count
+mem _ZL13default_count
+
+q
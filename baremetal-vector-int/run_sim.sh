@@ -0,0 +1,22 @@
+#!/bin/bash
+
+SPIKE=../../riscv-isa-sim/spike
+CMD_FILE=./test/run_sim.cmd
+MARCH=rv32imac_zicsr_zicntr
+MMAP=0x8000000:0x2000,0x80000000:0x4000,0x20010000:0x6a120
+CYCLES=100000
+
+# Run the interrupt attribute version, then the nesting dispatcher version
+for ELF in main main_nested ; do
+    echo "--- ${ELF} ---"
+    ${SPIKE} \
+        --priv=m \
+        --isa=${MARCH} \
+        -l \
+        -m${MMAP} \
+        --max-cycles ${CYCLES} \
+        --log test/run_sim_${ELF}.log \
+        -d \
+        --debug-cmd=${CMD_FILE} \
+        build/${ELF}.elf 2> test/trace_${ELF}.log
+done
@@ -0,0 +1,263 @@
+/*
+   Machine mode ecall gateway.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef ECALL_GATEWAY_H
+#define ECALL_GATEWAY_H
+
+#include "riscv-csr.h"
+#include "vector_table.h"
+
+/* The gateway is the synchronous exception entry (riscv_mtvec_exception).
+
+   An ecall (from U, S or M mode) is dispatched on a7 to a constant table
+   of handlers. The arguments are a0 to a5, the result is returned in a0
+   and mepc is advanced past the ecall. An id outside the table returns
+   ECALL_GATEWAY_ENOSYS. Any other exception is passed to a regular
+   interrupt ("machine") handler with all registers intact.
+
+   The ecall follows the C calling convention, ecall_call6() declares the
+   caller saved registers as clobbered. The gateway saves only t0, mepc
+   and mstatus, the handler is a plain C function.
+
+   The handler runs in M-mode, the caller sp is not used for a U or
+   S-mode ecall. mscratch must be 0 or the top of an M-mode stack while
+   no trap is handled, e.g. isr_stack_init() (isr_stack.h). It can not be
+   the save area of riscv_mtvec_fast_init(). With mscratch 0 an ecall
+   from U or S-mode returns ECALL_GATEWAY_ENOSYS. A handler called from
+   U or S-mode must check any pointer argument. OTHER is entered with
+   the registers of the trap, including the caller sp.
+
+   Usage:
+
+   static uint_xlen_t sys_null(ECALL_GATEWAY_ARGS) { return 0; }
+
+   ECALL_GATEWAY_TABLE(syscall_table) = {
+       [0] = sys_null,
+   };
+   ECALL_GATEWAY(riscv_mtvec_exception, syscall_table, exception_handler)
+
+   uint_xlen_t result = ecall_call0(0);
+*/
+
+#if defined(__riscv_32e)
+#error "The ecall gateway passes the id in a7, not available on RV32E"
+#endif
+
+#ifndef ECALL_GATEWAY_ENTRIES
+// Number of ecall ids in the table
+#define ECALL_GATEWAY_ENTRIES 16
+#endif
+
+// Returned in a0 for an id outside the table
+#define ECALL_GATEWAY_ENOSYS ((uint_xlen_t)-1)
+
+#if (__riscv_xlen == 64)
+#define ECALL_GATEWAY_REGSHIFT "3"
+#define ECALL_GATEWAY_FRAME    "64"
+#else
+#define ECALL_GATEWAY_REGSHIFT "2"
+#define ECALL_GATEWAY_FRAME    "32"
+#endif
+
+#define ECALL_GATEWAY_STR_(X) #X
+#define ECALL_GATEWAY_STR(X) ECALL_GATEWAY_STR_(X)
+
+#define ECALL_GATEWAY_SAVE(REG, N)    VECTOR_TABLE_STORE " " #REG ", " #N "*" VECTOR_TABLE_REGBYTES "(sp);"
+#define ECALL_GATEWAY_RESTORE(REG, N) VECTOR_TABLE_LOAD  " " #REG ", " #N "*" VECTOR_TABLE_REGBYTES "(sp);"
+
+/* Return to U or S-mode, clear the M-mode values left by the handler in
+   the caller saved registers, a0 is the result. t0 holds mstatus, t1 is
+   scratch and is cleared. The FP registers are cleared unless mstatus.FS
+   is Off, a write with FS Off would trap. */
+#define ECALL_GATEWAY_CLEAR_INT                                 \
+    "mv    ra, zero; mv    t1, zero; mv    t2, zero;"           \
+    "mv    t3, zero; mv    t4, zero; mv    t5, zero;"           \
+    "mv    t6, zero; mv    a1, zero; mv    a2, zero;"           \
+    "mv    a3, zero; mv    a4, zero; mv    a5, zero;"           \
+    "mv    a6, zero; mv    a7, zero;"
+
+#if defined(__riscv_flen)
+#if (__riscv_flen == 64)
+#define ECALL_GATEWAY_FZERO "fcvt.d.w"
+#else
+#define ECALL_GATEWAY_FZERO "fmv.w.x"
+#endif
+#define ECALL_GATEWAY_CLEAR_FP                                  \
+    "srli  t1, t0, 13;"                                         \
+    "andi  t1, t1, 3;"                                          \
+    "beqz  t1, 9f;"                                             \
+    "mv    t1, zero;"                                           \
+    ".irp  r,ft0,ft1,ft2,ft3,ft4,ft5,ft6,ft7,ft8,ft9,ft10,ft11,fa0,fa1,fa2,fa3,fa4,fa5,fa6,fa7;" \
+    ECALL_GATEWAY_FZERO " \\r, zero;"                          \
+    ".endr;"                                                    \
+    "9:"
+#else
+#define ECALL_GATEWAY_CLEAR_FP
+#endif
+
+/** Parameters of an ecall handler */
+#define ECALL_GATEWAY_ARGS                                      \
+    uint_xlen_t a0, uint_xlen_t a1, uint_xlen_t a2,             \
+    uint_xlen_t a3, uint_xlen_t a4, uint_xlen_t a5
+
+/** Ecall handler, unused arguments are ignored. */
+typedef uint_xlen_t (*ecall_handler_t)(ECALL_GATEWAY_ARGS);
+
+/** Define the table of ecall handlers indexed by a7.
+    Not static, the table is referenced by the gateway assembly. */
+#define ECALL_GATEWAY_TABLE(NAME) \
+    const ecall_handler_t NAME[ECALL_GATEWAY_ENTRIES]
+
+/** Define the gateway NAME, a naked exception entry. The ecall
+    handlers are in TABLE, other exceptions jump to OTHER, an interrupt
+    ("machine") function or naked entry with external linkage.
+
+    The frame is pushed on the M-mode stack from mscratch when it is not
+    0, and mscratch is 0 while the handler runs. When mscratch is 0 only
+    an M-mode caller may use its own sp, an ecall from U or S-mode
+    returns ECALL_GATEWAY_ENOSYS without any store.
+
+    On return to U or S-mode the caller saved registers other than a0,
+    and the FP temporaries when mstatus.FS is not Off, are cleared.
+
+    Frame: 0: t0, 1: mepc, 2: mstatus, 3: the caller sp, 4: mscratch.
+    mepc and mstatus are saved so a handler may fault, or enable
+    interrupts, without losing the return state.
+*/
+#define ECALL_GATEWAY(NAME, TABLE, OTHER)                                       \
+    void NAME(void) __attribute__ ((naked, aligned(4)));                        \
+    void NAME(void) {                                                           \
+        __asm__ volatile (                                                      \
+            "csrrw sp, mscratch, sp;"                                           \
+            "bnez  sp, 1f;"                                                     \
+            /* mscratch = 0, only an M-mode caller may use its own sp */        \
+            VECTOR_TABLE_MPP_NOT_M(sp)                                          \
+            "bnez  sp, 6f;"                                                     \
+            "csrrw sp, mscratch, zero;"                                         \
+            "addi  sp, sp, -" ECALL_GATEWAY_FRAME ";"                           \
+            ECALL_GATEWAY_SAVE(t0, 0)                                           \
+            "addi  t0, sp, " ECALL_GATEWAY_FRAME ";"                            \
+            ECALL_GATEWAY_SAVE(t0, 3)                                           \
+            ECALL_GATEWAY_SAVE(zero, 4)                                         \
+            "j     2f;"                                                         \
+            "1:"                                                                \
+            /* On the M-mode stack, mscratch = caller sp */                     \
+            "addi  sp, sp, -" ECALL_GATEWAY_FRAME ";"                           \
+            ECALL_GATEWAY_SAVE(t0, 0)                                           \
+            "csrrw t0, mscratch, zero;"                                         \
+            ECALL_GATEWAY_SAVE(t0, 3)                                           \
+            "addi  t0, sp, " ECALL_GATEWAY_FRAME ";"                            \
+            ECALL_GATEWAY_SAVE(t0, 4)                                           \
+            "2:"                                                                \
+            /* ecall from U, S or M mode is cause 8, 9 or 11 */                 \
+            "csrr  t0, mcause;"                                                 \
+            "srli  t0, t0, 2;"                                                  \
+            "addi  t0, t0, -2;"                                                 \
+            "bnez  t0, 3f;"                                                     \
+            /* ecall has no compressed encoding, always 4 bytes */              \
+            "csrr  t0, mepc;"                                                   \
+            "addi  t0, t0, 4;"                                                  \
+            ECALL_GATEWAY_SAVE(t0, 1)                                           \
+            "csrr  t0, mstatus;"                                                \
+            ECALL_GATEWAY_SAVE(t0, 2)                                           \
+            "li    t0, " ECALL_GATEWAY_STR(ECALL_GATEWAY_ENTRIES) ";"           \
+            "bgeu  a7, t0, 4f;"                                                 \
+            "la    t0, " #TABLE ";"                                             \
+            "slli  a7, a7, " ECALL_GATEWAY_REGSHIFT ";"                         \
+            "add   t0, t0, a7;"                                                 \
+            VECTOR_TABLE_LOAD " t0, 0(t0);"                                     \
+            "jalr  ra, 0(t0);"                                                  \
+            "j     5f;"                                                         \
+            "4:"                                                                \
+            "li    a0, -1;"                                                     \
+            "5:"                                                                \
+            ECALL_GATEWAY_RESTORE(t0, 1)                                        \
+            "csrw  mepc, t0;"                                                   \
+            ECALL_GATEWAY_RESTORE(t0, 2)                                        \
+            /* Returning to U or S-mode, do not leak M-mode values */           \
+            "srli  t1, t0, 11;"                                                 \
+            "andi  t1, t1, 3;"                                                  \
+            "addi  t1, t1, -3;"                                                 \
+            "beqz  t1, 8f;"                                                     \
+            ECALL_GATEWAY_CLEAR_INT                                             \
+            ECALL_GATEWAY_CLEAR_FP                                              \
+            "8:"                                                                \
+            "csrw  mstatus, t0;"                                                \
+            ECALL_GATEWAY_RESTORE(t0, 4)                                        \
+            "csrw  mscratch, t0;"                                               \
+            "mv    t0, zero;"                                                   \
+            ECALL_GATEWAY_RESTORE(sp, 3)                                        \
+            "mret;"                                                             \
+            /* Not an ecall, restore t0, mscratch and sp */                     \
+            "3:"                                                                \
+            ECALL_GATEWAY_RESTORE(t0, 4)                                        \
+            "csrw  mscratch, t0;"                                               \
+            ECALL_GATEWAY_RESTORE(t0, 0)                                        \
+            ECALL_GATEWAY_RESTORE(sp, 3)                                        \
+            "j     " #OTHER ";"                                                 \
+            /* From U or S-mode with no M-mode stack, sp is the only scratch */ \
+            "6:"                                                                \
+            "csrr  sp, mcause;"                                                 \
+            "srli  sp, sp, 2;"                                                  \
+            "addi  sp, sp, -2;"                                                 \
+            "bnez  sp, 7f;"                                                     \
+            "csrr  sp, mepc;"                                                   \
+            "addi  sp, sp, 4;"                                                  \
+            "csrw  mepc, sp;"                                                   \
+            "li    a0, -1;"                                                     \
+            "csrrw sp, mscratch, zero;"                                         \
+            "mret;"                                                             \
+            "7:"                                                                \
+            "csrrw sp, mscratch, zero;"                                         \
+            "j     " #OTHER ";"                                                 \
+            );                                                                  \
+    }
+
+#if defined(__riscv_flen)
+#define ECALL_GATEWAY_CLOBBER_FP ,                                      \
+        "ft0", "ft1", "ft2", "ft3", "ft4", "ft5", "ft6", "ft7",         \
+        "ft8", "ft9", "ft10", "ft11",                                   \
+        "fa0", "fa1", "fa2", "fa3", "fa4", "fa5", "fa6", "fa7"
+#else
+#define ECALL_GATEWAY_CLOBBER_FP
+#endif
+
+/** Call ecall handler 'id' with 6 arguments, returns a0 of the handler */
+static inline uint_xlen_t ecall_call6(uint_xlen_t id,
+                                      uint_xlen_t a0, uint_xlen_t a1, uint_xlen_t a2,
+                                      uint_xlen_t a3, uint_xlen_t a4, uint_xlen_t a5) {
+    register uint_xlen_t r_a0 __asm__ ("a0") = a0;
+    register uint_xlen_t r_a1 __asm__ ("a1") = a1;
+    register uint_xlen_t r_a2 __asm__ ("a2") = a2;
+    register uint_xlen_t r_a3 __asm__ ("a3") = a3;
+    register uint_xlen_t r_a4 __asm__ ("a4") = a4;
+    register uint_xlen_t r_a5 __asm__ ("a5") = a5;
+    register uint_xlen_t r_a7 __asm__ ("a7") = id;
+    __asm__ volatile ("ecall"
+                      : "+r" (r_a0), "+r" (r_a1), "+r" (r_a2), "+r" (r_a3),
+                        "+r" (r_a4), "+r" (r_a5), "+r" (r_a7)
+                      :
+                      : "ra", "t0", "t1", "t2", "t3", "t4", "t5", "t6", "a6",
+                        "memory" ECALL_GATEWAY_CLOBBER_FP);
+    return r_a0;
+}
+
+/** Call ecall handler 'id' with no arguments */
+static inline uint_xlen_t ecall_call0(uint_xlen_t id) {
+    register uint_xlen_t r_a0 __asm__ ("a0");
+    register uint_xlen_t r_a7 __asm__ ("a7") = id;
+    __asm__ volatile ("ecall"
+                      : "=r" (r_a0), "+r" (r_a7)
+                      :
+                      : "ra", "t0", "t1", "t2", "t3", "t4", "t5", "t6",
+                        "a1", "a2", "a3", "a4", "a5", "a6",
+                        "memory" ECALL_GATEWAY_CLOBBER_FP);
+    return r_a0;
+}
+
+#endif // #ifdef ECALL_GATEWAY_H
@@ -0,0 +1,66 @@
+/*
+   Interrupt coalescing with adaptive switching between interrupt and polled mode.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#include "riscv-csr.h"
+#include "irq_coalesce.h"
+#include "vector_table.h"
+
+// Service events until none is pending or the budget is used.
+static uint32_t irq_coalesce_service(struct irq_coalesce *coalesce) {
+    uint_xlen_t start = csr_read_mcycle();
+    uint32_t events = 0;
+    coalesce->budget_exhausted = 0;
+    while (events < IRQ_COALESCE_BUDGET_EVENTS) {
+        if (!coalesce->service()) {
+            break;
+        }
+        events++;
+        if ((uint_xlen_t)(csr_read_mcycle() - start) >= IRQ_COALESCE_BUDGET_CYCLES) {
+            coalesce->budget_exhausted = 1;
+            break;
+        }
+    }
+    coalesce->event_count += events;
+    return events;
+}
+
+static void irq_coalesce_enter_polled(struct irq_coalesce *coalesce) {
+    // Kept masked when a nesting dispatcher returns
+    riscv_mtvec_mask(coalesce->mie_mask);
+    coalesce->polled = 1;
+    coalesce->poll_enter_count++;
+}
+
+static void irq_coalesce_exit_polled(struct irq_coalesce *coalesce) {
+    coalesce->polled = 0;
+    riscv_mtvec_unmask(coalesce->mie_mask);
+}
+
+void irq_coalesce_irq(struct irq_coalesce *coalesce) {
+    coalesce->irq_count++;
+    uint32_t events = irq_coalesce_service(coalesce);
+    coalesce->window_events += events;
+    if ((events >= IRQ_COALESCE_BUDGET_EVENTS) || coalesce->budget_exhausted) {
+        // Still busy, stop taking interrupts
+        irq_coalesce_enter_polled(coalesce);
+    }
+}
+
+void irq_coalesce_tick(struct irq_coalesce *coalesce) {
+    if (coalesce->polled) {
+        coalesce->poll_count++;
+        uint32_t events = irq_coalesce_service(coalesce);
+        if ((events < IRQ_COALESCE_POLL_EXIT_EVENTS) && !coalesce->budget_exhausted) {
+            // Load has fallen
+            irq_coalesce_exit_polled(coalesce);
+        }
+    } else if (coalesce->window_events > IRQ_COALESCE_POLL_ENTER_EVENTS) {
+        irq_coalesce_enter_polled(coalesce);
+    }
+    coalesce->window_events = 0;
+}
@@ -0,0 +1,109 @@
+/*
+   Interrupt coalescing with adaptive switching between interrupt and polled mode.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef IRQ_COALESCE_H
+#define IRQ_COALESCE_H
+
+#include <stdint.h>
+
+#include "riscv-csr.h"
+
+/* Coalesce the events of a high rate interrupt source (NAPI style), the
+   C version of riscv::irq_coalesce (baremetal-startup-cxx/src/irq_coalesce.hpp).
+
+   In interrupt mode the handler of the source, e.g. riscv_mtvec_mei(),
+   calls irq_coalesce_irq(). Each entry services up to
+   IRQ_COALESCE_BUDGET_EVENTS events, or until IRQ_COALESCE_BUDGET_CYCLES
+   have passed, so several events share one trap entry.
+
+   The timer handler, riscv_mtvec_mti(), calls irq_coalesce_tick(). If
+   the budget of an interrupt entry was exhausted, or more than
+   IRQ_COALESCE_POLL_ENTER_EVENTS were handled since the last tick, the
+   source is masked in mie and the events are serviced by the tick
+   instead. When a poll handles fewer than IRQ_COALESCE_POLL_EXIT_EVENTS
+   the source is unmasked and interrupt mode resumes. A level triggered
+   source that is still pending is taken again as soon as it is unmasked.
+
+   Both functions must be called with interrupts disabled, the default
+   for the vector table handlers. With VECTOR_TABLE_MTVEC_NESTED give the
+   source and mti the same nesting priority. The source is masked and
+   unmasked with riscv_mtvec_mask() and riscv_mtvec_unmask() (vector_table.h),
+   so the nesting dispatcher does not enable it again on return.
+
+   e.g. Coalesce the external interrupt:
+
+   static int rx_packet(void);  // Service one event, 0 if none was pending
+   static struct irq_coalesce rx_coalesce = IRQ_COALESCE_INIT(rx_packet, MIE_MEI_BIT_MASK);
+
+   void riscv_mtvec_mei(void) {
+       irq_coalesce_irq(&rx_coalesce);
+   }
+   void riscv_mtvec_mti(void) {
+       mtimer_set_raw_time_cmp(MTIMER_MSEC_TO_CLOCKS(1));
+       irq_coalesce_tick(&rx_coalesce);
+   }
+*/
+
+#ifndef IRQ_COALESCE_BUDGET_EVENTS
+// Maximum events handled per interrupt entry or per poll
+#define IRQ_COALESCE_BUDGET_EVENTS 16
+#endif
+
+#ifndef IRQ_COALESCE_BUDGET_CYCLES
+// Maximum mcycle clocks spent per interrupt entry or per poll
+#define IRQ_COALESCE_BUDGET_CYCLES 4096
+#endif
+
+#ifndef IRQ_COALESCE_POLL_ENTER_EVENTS
+// Switch to polled mode when more events than this are handled in one timer tick
+#define IRQ_COALESCE_POLL_ENTER_EVENTS 32
+#endif
+
+#ifndef IRQ_COALESCE_POLL_EXIT_EVENTS
+// Switch back to interrupt mode when fewer events than this are handled by a poll
+#define IRQ_COALESCE_POLL_EXIT_EVENTS 4
+#endif
+
+#if (IRQ_COALESCE_POLL_EXIT_EVENTS > IRQ_COALESCE_BUDGET_EVENTS)
+#error "IRQ_COALESCE_POLL_EXIT_EVENTS must not exceed IRQ_COALESCE_BUDGET_EVENTS"
+#endif
+
+/** Service one event, return 0 if no event was pending. */
+typedef int (*irq_coalesce_service_t)(void);
+
+/** State and statistics of a coalesced source, inspect with a debugger. */
+struct irq_coalesce {
+    irq_coalesce_service_t service;
+    // mie bit of the source, e.g. MIE_MEI_BIT_MASK
+    uint_xlen_t mie_mask;
+    // 1 while the source is masked and serviced by irq_coalesce_tick()
+    volatile uint32_t polled;
+    // Interrupt entries
+    volatile uint32_t irq_count;
+    // Polls by irq_coalesce_tick()
+    volatile uint32_t poll_count;
+    // Total events serviced
+    volatile uint32_t event_count;
+    // Switches from interrupt to polled mode
+    volatile uint32_t poll_enter_count;
+    // Events handled in interrupt mode since the last tick
+    uint32_t window_events;
+    // The last service loop stopped on the cycle budget
+    uint32_t budget_exhausted;
+};
+
+/** Static initializer of a struct irq_coalesce. */
+#define IRQ_COALESCE_INIT(SERVICE, MIE_MASK) { .service = (SERVICE), .mie_mask = (MIE_MASK) }
+
+/** Call from the interrupt handler of the source. */
+void irq_coalesce_irq(struct irq_coalesce *coalesce);
+
+/** Call from a periodic timer handler. */
+void irq_coalesce_tick(struct irq_coalesce *coalesce);
+
+#endif // #ifndef IRQ_COALESCE_H
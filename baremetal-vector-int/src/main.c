@@ -15,26 +15,80 @@
 #include "timer.h"
 
 #include "vector_table.h"
+#include "ecall_gateway.h"
+#include "trap_emulate.h"
+#include "irq_coalesce.h"
 
 // Machine mode interrupt service routine
 
 // Global to hold current timestamp, written in MTI handler.
 static volatile uint64_t timestamp = 0;
-// Expect this to increment one time per second - inside exception handler, after each return of MTI handler.
+// Expect this to increment one time per second - inside the SYSCALL_COUNT handler, after each return of MTI handler.
 static volatile uint64_t ecall_count = 0;
+// Result of SYSCALL_SUM, the sum of the 6 arguments
+static volatile uint_xlen_t ecall_sum_result = 0;
+// Count of exceptions that are not ecall and are not emulated
+static volatile uint32_t exception_count = 0;
+
+// Emulated when the core traps on misaligned access, see trap_emulate_sites for the count
+static uint8_t misaligned_buffer[8];
+static volatile uint32_t misaligned_result = 0;
+// Emulated when the core does not implement the M extension
+static volatile uint_xlen_t mul_operand = 1234;
+static volatile uint_xlen_t mul_result = 0;
+
+// Number of null ecalls per measurement
+#define BENCH_ITERATIONS 64
+// Results in cycles, for BENCH_ITERATIONS iterations. Traced by test/run_sim.cmd
+static volatile uint_xlen_t null_ecall_cycles = 0;
+static volatile uint_xlen_t loop_cycles = 0;
+
+// Events waiting in the external device, serviced by mei_service().
+// The ISA simulator does not raise MEI, a real device reports its own status.
+static volatile uint32_t mei_fifo_level = 0;
+static int mei_service(void);
+// The external interrupt is coalesced, and polled by the timer tick under load.
+static struct irq_coalesce mei_coalesce = IRQ_COALESCE_INIT(mei_service, MIE_MEI_BIT_MASK);
 
 #define RISCV_MTVEC_MODE_VECTORED 1
 
+// ecall ids, the index in syscall_table
+enum {
+    SYSCALL_NULL  = 0,
+    SYSCALL_COUNT = 1,
+    SYSCALL_SUM   = 2,
+};
+
+static uint_xlen_t sys_null(ECALL_GATEWAY_ARGS);
+static uint_xlen_t sys_count(ECALL_GATEWAY_ARGS);
+static uint_xlen_t sys_sum(ECALL_GATEWAY_ARGS);
+
+// Handlers for the ecall gateway, indexed by a7
+ECALL_GATEWAY_TABLE(syscall_table) = {
+    [SYSCALL_NULL]  = sys_null,
+    [SYSCALL_COUNT] = sys_count,
+    [SYSCALL_SUM]   = sys_sum,
+};
+
+static void bench_null_ecall(void);
+
 int main(void) {
     // Global interrupt disable
     csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
     csr_write_mie(0);
+
+    // No M-mode stack for the gateway, only M-mode ecalls are handled
+    csr_write_mscratch(0);
     
     // Setup the IRQ handler entry point, set the mode to vectored
     csr_write_mtvec((uint_xlen_t) riscv_mtvec_table | RISCV_MTVEC_MODE_VECTORED);
 
-    // Enable MIE.MTI
-    csr_set_bits_mie(MIE_MTI_BIT_MASK);
+    // Measure the round trip of an ecall through the gateway, without interrupts
+    bench_null_ecall();
+    ecall_sum_result = ecall_call6(SYSCALL_SUM, 1, 2, 3, 4, 5, 6);
+
+    // Enable MIE.MTI and MIE.MEI
+    csr_set_bits_mie(MIE_MTI_BIT_MASK | MIE_MEI_BIT_MASK);
 
     // Global interrupt enable 
     csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
@@ -48,7 +102,12 @@ int main(void) {
         // Wait for timer interrupt
         __asm__ volatile ("wfi");
         // Try a synchronous exception.
-        __asm__ volatile ("ecall");
+        ecall_call0(SYSCALL_COUNT);
+        // Try the emulated instructions, the same sites trap each time
+        volatile uint32_t *misaligned = (volatile uint32_t *)&misaligned_buffer[1];
+        *misaligned = (uint32_t)ecall_count;
+        misaligned_result = *misaligned;
+        mul_result = mul_operand * mul_operand;
     } while (1);
     
     // Will not reach here
@@ -63,21 +122,60 @@ void riscv_mtvec_mti(void)  {
     // Timer exception, re-program the timer for a one second tick.
     mtimer_set_raw_time_cmp(MTIMER_SECONDS_TO_CLOCKS(1));
     timestamp = mtimer_get_raw_time();
+    // Poll the external interrupt source if it is in polled mode
+    irq_coalesce_tick(&mei_coalesce);
 }
-// The 'riscv_mtvec_exception' function is added to the vector table by the vector_table.c
-// This function looks at the cause of the exception, if it is an 'ecall' instruction then increment a global counter.
-void riscv_mtvec_exception(void)  {
-    uint_xlen_t this_cause = csr_read_mcause();
-    uint_xlen_t this_pc    = csr_read_mepc();
-    //uint_xlen_t this_value = csr_read_mtval();
-    switch (this_cause) {
-        case RISCV_EXCP_ENVIRONMENT_CALL_FROM_M_MODE:
-            ecall_count++;
-            // Make sure the return address is the instruction AFTER ecall
-            csr_write_mepc(this_pc+4);
-            break;
-    }
+// The 'riscv_mtvec_mei' function is added to the vector table by the vector_table.c
+void riscv_mtvec_mei(void)  {
+    irq_coalesce_irq(&mei_coalesce);
 }
+// The 'riscv_mtvec_exception' function is added to the vector table by the vector_table.c
+// An ecall is dispatched to syscall_table, other exceptions to the emulator (trap_emulate.c).
+ECALL_GATEWAY(riscv_mtvec_exception, syscall_table, riscv_mtvec_emulate)
 #pragma GCC pop_options
 
+// Called by the emulator for any other exception, skip the instruction.
+void trap_emulate_unhandled(trap_emulate_frame_t *frame, uint_xlen_t cause) {
+    (void)cause;
+    exception_count++;
+    uint16_t insn = *(const volatile uint16_t *)frame->mepc;
+    frame->mepc += ((insn & 0x3) == 0x3) ? 4 : 2;
+}
 
+static uint_xlen_t sys_null(ECALL_GATEWAY_ARGS) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return 0;
+}
+
+static uint_xlen_t sys_count(ECALL_GATEWAY_ARGS) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    ecall_count++;
+    return 0;
+}
+
+static uint_xlen_t sys_sum(ECALL_GATEWAY_ARGS) {
+    return a0 + a1 + a2 + a3 + a4 + a5;
+}
+
+static void bench_null_ecall(void) {
+    // Loop overhead only, subtract from null_ecall_cycles
+    uint_xlen_t start_cycle = csr_read_mcycle();
+    for (unsigned int i = 0; i < BENCH_ITERATIONS; i++) {
+        __asm__ volatile ("" ::: "memory");
+    }
+    loop_cycles = csr_read_mcycle() - start_cycle;
+    start_cycle = csr_read_mcycle();
+    for (unsigned int i = 0; i < BENCH_ITERATIONS; i++) {
+        ecall_call0(SYSCALL_NULL);
+    }
+    null_ecall_cycles = csr_read_mcycle() - start_cycle;
+}
+
+// Service one event of the external device, 0 if none was waiting.
+static int mei_service(void) {
+    if (mei_fifo_level == 0) {
+        return 0;
+    }
+    mei_fifo_level--;
+    return 1;
+}
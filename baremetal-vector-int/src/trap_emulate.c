@@ -0,0 +1,486 @@
+/*
+   Trap and emulate misaligned load/store and M extension instructions.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+#include "vector_table.h"
+#include "trap_emulate.h"
+
+volatile trap_emulate_site_t trap_emulate_sites[TRAP_EMULATE_SITES];
+volatile uint32_t trap_emulate_count = 0;
+volatile uint32_t trap_emulate_decode_count = 0;
+
+// Emulated operations, trap_emulate_site_t.op
+enum {
+    TRAP_EMULATE_OP_NONE = 0,
+    TRAP_EMULATE_OP_LH,
+    TRAP_EMULATE_OP_LHU,
+    TRAP_EMULATE_OP_LW,
+    TRAP_EMULATE_OP_LWU,
+    TRAP_EMULATE_OP_LD,
+    TRAP_EMULATE_OP_SH,
+    TRAP_EMULATE_OP_SW,
+    TRAP_EMULATE_OP_SD,
+    TRAP_EMULATE_OP_MUL,
+    TRAP_EMULATE_OP_MULH,
+    TRAP_EMULATE_OP_MULHSU,
+    TRAP_EMULATE_OP_MULHU,
+    TRAP_EMULATE_OP_DIV,
+    TRAP_EMULATE_OP_DIVU,
+    TRAP_EMULATE_OP_REM,
+    TRAP_EMULATE_OP_REMU,
+    TRAP_EMULATE_OP_MULW,
+    TRAP_EMULATE_OP_DIVW,
+    TRAP_EMULATE_OP_DIVUW,
+    TRAP_EMULATE_OP_REMW,
+    TRAP_EMULATE_OP_REMUW,
+};
+
+#define XLEN_MSB ((uint_xlen_t)1 << (__riscv_xlen - 1))
+
+// Value of mstatus.MPP for a trap from machine mode
+#define TRAP_EMULATE_PRIV_MODE_M 3
+
+#if (__riscv_xlen == 64)
+typedef int64_t int_xlen_t;
+#define TRAP_EMULATE_FRAME "288"
+#else
+typedef int32_t int_xlen_t;
+#define TRAP_EMULATE_FRAME "144"
+#endif
+
+#if defined(__riscv_32e)
+#define TRAP_EMULATE_REGS "1,3,4,5,6,7,8,9,10,11,12,13,14,15"
+#else
+#define TRAP_EMULATE_REGS "1,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31"
+#endif
+
+#define TRAP_EMULATE_SAVE_REGS                                  \
+    ".irp  n," TRAP_EMULATE_REGS ";"                            \
+    VECTOR_TABLE_STORE " x\\n, \\n*" VECTOR_TABLE_REGBYTES "(sp);"  \
+    ".endr;"
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+// Save x1 and x3-x31 to a trap_emulate_frame_t on the stack, x2 (sp) is saved as the value before the trap.
+// The frame is on the M-mode stack in mscratch when it is not 0, otherwise only an M-mode
+// trap may use its own sp. sp is restored last, from the frame, so an emulated load can write it.
+void riscv_mtvec_emulate(void) {
+    __asm__ volatile (
+        "csrrw sp, mscratch, sp;"
+        "bnez  sp, 1f;"
+        /* mscratch = 0, a trap from U or S-mode has no stack */
+        VECTOR_TABLE_MPP_NOT_M(sp)
+        "bnez  sp, 3f;"
+        "csrrw sp, mscratch, zero;"
+        "addi  sp, sp, -" TRAP_EMULATE_FRAME ";"
+        TRAP_EMULATE_SAVE_REGS
+        "addi  t0, sp, " TRAP_EMULATE_FRAME ";"
+        VECTOR_TABLE_STORE " t0, 2*" VECTOR_TABLE_REGBYTES "(sp);"
+        VECTOR_TABLE_STORE " zero, 34*" VECTOR_TABLE_REGBYTES "(sp);"
+        "j     2f;"
+        "1:"
+        /* On the M-mode stack, mscratch = interrupted sp */
+        "addi  sp, sp, -" TRAP_EMULATE_FRAME ";"
+        TRAP_EMULATE_SAVE_REGS
+        "csrrw t0, mscratch, zero;"
+        VECTOR_TABLE_STORE " t0, 2*" VECTOR_TABLE_REGBYTES "(sp);"
+        "addi  t0, sp, " TRAP_EMULATE_FRAME ";"
+        VECTOR_TABLE_STORE " t0, 34*" VECTOR_TABLE_REGBYTES "(sp);"
+        "2:"
+        VECTOR_TABLE_STORE " zero, 0(sp);"
+        "csrr  t0, mepc;"
+        VECTOR_TABLE_STORE " t0, 32*" VECTOR_TABLE_REGBYTES "(sp);"
+        "csrr  t0, mstatus;"
+        VECTOR_TABLE_STORE " t0, 33*" VECTOR_TABLE_REGBYTES "(sp);"
+        "mv    a0, sp;"
+        "call  trap_emulate;"
+        VECTOR_TABLE_LOAD " t0, 32*" VECTOR_TABLE_REGBYTES "(sp);"
+        "csrw  mepc, t0;"
+        VECTOR_TABLE_LOAD " t0, 33*" VECTOR_TABLE_REGBYTES "(sp);"
+        "csrw  mstatus, t0;"
+        VECTOR_TABLE_LOAD " t0, 34*" VECTOR_TABLE_REGBYTES "(sp);"
+        "csrw  mscratch, t0;"
+        ".irp  n," TRAP_EMULATE_REGS ";"
+        VECTOR_TABLE_LOAD " x\\n, \\n*" VECTOR_TABLE_REGBYTES "(sp);"
+        ".endr;"
+        VECTOR_TABLE_LOAD " sp, 2*" VECTOR_TABLE_REGBYTES "(sp);"
+        "mret;"
+        /* No M-mode stack for a trap from U or S-mode, halt */
+        "3:"
+        "wfi;"
+        "j     3b;"
+        );
+}
+#pragma GCC pop_options
+
+void trap_emulate_unhandled(trap_emulate_frame_t *frame, uint_xlen_t cause) __attribute__ ((weak));
+void trap_emulate_unhandled(trap_emulate_frame_t *frame, uint_xlen_t cause) {
+    (void)frame;
+    (void)cause;
+}
+
+void trap_emulate_flush(void) {
+    for (unsigned int i = 0; i < TRAP_EMULATE_SITES; i++) {
+        trap_emulate_sites[i].pc = 0;
+        trap_emulate_sites[i].count = 0;
+    }
+}
+
+/* Decode */
+
+// Sign extend the low 'bits' of 'value'
+static inline uint_xlen_t sign_extend(uint_xlen_t value, unsigned int bits) {
+    unsigned int shift = __riscv_xlen - bits;
+    return (uint_xlen_t)(((int_xlen_t)(value << shift)) >> shift);
+}
+
+// Registers x8-x15 of the compressed instructions
+#define C_RS1_PRIME(INSN) ((uint8_t)(8 + (((INSN) >> 7) & 0x7)))
+#define C_RS2_PRIME(INSN) ((uint8_t)(8 + (((INSN) >> 2) & 0x7)))
+// Offset of C.LW/C.SW
+#define C_W_IMM(INSN)  ((((INSN) >> 7) & 0x38) | (((INSN) >> 4) & 0x4) | (((INSN) << 1) & 0x40))
+// Offset of C.LD/C.SD
+#define C_D_IMM(INSN)  ((((INSN) >> 7) & 0x38) | (((INSN) << 1) & 0xC0))
+
+static bool decode_compressed(uint32_t insn, trap_emulate_site_t *site) {
+    unsigned int funct3 = (insn >> 13) & 0x7;
+    site->length = 2;
+    switch (insn & 0x3) {
+    case 0:
+        switch (funct3) {
+        case 2: // C.LW
+            site->op = TRAP_EMULATE_OP_LW;
+            site->rd = C_RS2_PRIME(insn);
+            site->rs1 = C_RS1_PRIME(insn);
+            site->imm = C_W_IMM(insn);
+            return true;
+        case 6: // C.SW
+            site->op = TRAP_EMULATE_OP_SW;
+            site->rs1 = C_RS1_PRIME(insn);
+            site->rs2 = C_RS2_PRIME(insn);
+            site->imm = C_W_IMM(insn);
+            return true;
+#if (__riscv_xlen == 64)
+        case 3: // C.LD
+            site->op = TRAP_EMULATE_OP_LD;
+            site->rd = C_RS2_PRIME(insn);
+            site->rs1 = C_RS1_PRIME(insn);
+            site->imm = C_D_IMM(insn);
+            return true;
+        case 7: // C.SD
+            site->op = TRAP_EMULATE_OP_SD;
+            site->rs1 = C_RS1_PRIME(insn);
+            site->rs2 = C_RS2_PRIME(insn);
+            site->imm = C_D_IMM(insn);
+            return true;
+#endif
+        }
+        break;
+    case 2:
+        site->rs1 = 2;
+        switch (funct3) {
+        case 2: // C.LWSP
+            site->op = TRAP_EMULATE_OP_LW;
+            site->rd = (insn >> 7) & 0x1F;
+            site->imm = ((insn >> 7) & 0x20) | ((insn >> 2) & 0x1C) | ((insn << 4) & 0xC0);
+            return true;
+        case 6: // C.SWSP
+            site->op = TRAP_EMULATE_OP_SW;
+            site->rs2 = (insn >> 2) & 0x1F;
+            site->imm = ((insn >> 7) & 0x3C) | ((insn >> 1) & 0xC0);
+            return true;
+#if (__riscv_xlen == 64)
+        case 3: // C.LDSP
+            site->op = TRAP_EMULATE_OP_LD;
+            site->rd = (insn >> 7) & 0x1F;
+            site->imm = ((insn >> 7) & 0x20) | ((insn >> 2) & 0x18) | ((insn << 4) & 0x1C0);
+            return true;
+        case 7: // C.SDSP
+            site->op = TRAP_EMULATE_OP_SD;
+            site->rs2 = (insn >> 2) & 0x1F;
+            site->imm = ((insn >> 7) & 0x38) | ((insn >> 1) & 0x1C0);
+            return true;
+#endif
+        }
+        break;
+    }
+    return false;
+}
+
+static bool decode(uint32_t insn, trap_emulate_site_t *site) {
+    if ((insn & 0x3) != 0x3) {
+        return decode_compressed(insn, site);
+    }
+    unsigned int funct3 = (insn >> 12) & 0x7;
+    unsigned int funct7 = insn >> 25;
+    site->length = 4;
+    site->rd = (insn >> 7) & 0x1F;
+    site->rs1 = (insn >> 15) & 0x1F;
+    site->rs2 = (insn >> 20) & 0x1F;
+    switch (insn & 0x7F) {
+    case 0x03: { // LOAD
+        static const uint8_t load_ops[8] = {
+            TRAP_EMULATE_OP_NONE, TRAP_EMULATE_OP_LH, TRAP_EMULATE_OP_LW,
+#if (__riscv_xlen == 64)
+            TRAP_EMULATE_OP_LD,
+#else
+            TRAP_EMULATE_OP_NONE,
+#endif
+            TRAP_EMULATE_OP_NONE, TRAP_EMULATE_OP_LHU,
+#if (__riscv_xlen == 64)
+            TRAP_EMULATE_OP_LWU,
+#else
+            TRAP_EMULATE_OP_NONE,
+#endif
+            TRAP_EMULATE_OP_NONE,
+        };
+        site->op = load_ops[funct3];
+        site->imm = (int16_t)sign_extend(insn >> 20, 12);
+        break;
+    }
+    case 0x23: { // STORE
+        static const uint8_t store_ops[8] = {
+            TRAP_EMULATE_OP_NONE, TRAP_EMULATE_OP_SH, TRAP_EMULATE_OP_SW,
+#if (__riscv_xlen == 64)
+            TRAP_EMULATE_OP_SD,
+#else
+            TRAP_EMULATE_OP_NONE,
+#endif
+        };
+        site->op = (funct3 < 4) ? store_ops[funct3] : TRAP_EMULATE_OP_NONE;
+        site->imm = (int16_t)sign_extend(((insn >> 20) & 0xFE0) | ((insn >> 7) & 0x1F), 12);
+        break;
+    }
+    case 0x33: // OP, M extension when funct7 is 1
+        site->op = (funct7 == 1) ? (uint8_t)(TRAP_EMULATE_OP_MUL + funct3) : TRAP_EMULATE_OP_NONE;
+        break;
+#if (__riscv_xlen == 64)
+    case 0x3B: { // OP-32, M extension when funct7 is 1
+        static const uint8_t op32_ops[8] = {
+            TRAP_EMULATE_OP_MULW, TRAP_EMULATE_OP_NONE, TRAP_EMULATE_OP_NONE, TRAP_EMULATE_OP_NONE,
+            TRAP_EMULATE_OP_DIVW, TRAP_EMULATE_OP_DIVUW, TRAP_EMULATE_OP_REMW, TRAP_EMULATE_OP_REMUW,
+        };
+        site->op = (funct7 == 1) ? op32_ops[funct3] : TRAP_EMULATE_OP_NONE;
+        break;
+    }
+#endif
+    default:
+        site->op = TRAP_EMULATE_OP_NONE;
+        break;
+    }
+    return site->op != TRAP_EMULATE_OP_NONE;
+}
+
+/* Memory access, one byte at a time so the access can not be misaligned */
+
+static uint_xlen_t load_bytes(uintptr_t address, unsigned int bytes) {
+    const volatile uint8_t *p = (const volatile uint8_t *)address;
+    uint_xlen_t value = 0;
+    for (unsigned int i = bytes; i > 0; i--) {
+        value = (value << 8) | p[i - 1];
+    }
+    return value;
+}
+
+static void store_bytes(uintptr_t address, unsigned int bytes, uint_xlen_t value) {
+    volatile uint8_t *p = (volatile uint8_t *)address;
+    for (unsigned int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+/* Arithmetic, shift and add only so no M instruction is used */
+
+// Full 2*XLEN product of unsigned a and b
+static void mul_full(uint_xlen_t a, uint_xlen_t b, uint_xlen_t *hi, uint_xlen_t *lo) {
+    uint_xlen_t r_hi = 0;
+    uint_xlen_t r_lo = 0;
+    uint_xlen_t a_hi = 0;
+    // Iterate over the bits of the smaller operand
+    if (a < b) {
+        uint_xlen_t t = a;
+        a = b;
+        b = t;
+    }
+    while (b != 0) {
+        if (b & 1) {
+            uint_xlen_t t = r_lo + a;
+            r_hi += a_hi + (t < r_lo);
+            r_lo = t;
+        }
+        a_hi = (a_hi << 1) | (a >> (__riscv_xlen - 1));
+        a <<= 1;
+        b >>= 1;
+    }
+    *hi = r_hi;
+    *lo = r_lo;
+}
+
+// High XLEN bits of the product, 'a_signed' and 'b_signed' select MULH, MULHSU or MULHU
+static uint_xlen_t mul_high(uint_xlen_t a, uint_xlen_t b, bool a_signed, bool b_signed) {
+    bool negate = false;
+    if (a_signed && (a & XLEN_MSB)) {
+        a = -a;
+        negate = !negate;
+    }
+    if (b_signed && (b & XLEN_MSB)) {
+        b = -b;
+        negate = !negate;
+    }
+    uint_xlen_t hi, lo;
+    mul_full(a, b, &hi, &lo);
+    if (negate) {
+        // Two's complement of the 2*XLEN product
+        hi = ~hi + (lo == 0);
+    }
+    return hi;
+}
+
+// Unsigned division, d is not 0
+static uint_xlen_t divu(uint_xlen_t n, uint_xlen_t d, uint_xlen_t *rem) {
+    uint_xlen_t q = 0;
+    uint_xlen_t bit = 1;
+    // Align the divisor with the dividend, then one iteration per quotient bit
+    while ((d < n) && !(d & XLEN_MSB)) {
+        d <<= 1;
+        bit <<= 1;
+    }
+    while (bit != 0) {
+        if (n >= d) {
+            n -= d;
+            q |= bit;
+        }
+        d >>= 1;
+        bit >>= 1;
+    }
+    *rem = n;
+    return q;
+}
+
+// DIV/REM/DIVU/REMU, including the division by zero and overflow results of the ISA
+static uint_xlen_t div_rem(uint_xlen_t a, uint_xlen_t b, bool is_signed, bool is_rem) {
+    if (b == 0) {
+        return is_rem ? a : (uint_xlen_t)-1;
+    }
+    if (!is_signed) {
+        uint_xlen_t r;
+        uint_xlen_t q = divu(a, b, &r);
+        return is_rem ? r : q;
+    }
+    if ((a == XLEN_MSB) && (b == (uint_xlen_t)-1)) {
+        return is_rem ? 0 : a;
+    }
+    bool a_negative = (a & XLEN_MSB) != 0;
+    bool b_negative = (b & XLEN_MSB) != 0;
+    uint_xlen_t r;
+    uint_xlen_t q = divu(a_negative ? -a : a, b_negative ? -b : b, &r);
+    if (is_rem) {
+        // The remainder has the sign of the dividend
+        return a_negative ? -r : r;
+    }
+    return (a_negative != b_negative) ? -q : q;
+}
+
+static uint_xlen_t execute_m(unsigned int op, uint_xlen_t a, uint_xlen_t b) {
+    uint_xlen_t hi, lo;
+    switch (op) {
+    case TRAP_EMULATE_OP_MUL:
+        mul_full(a, b, &hi, &lo);
+        return lo;
+    case TRAP_EMULATE_OP_MULH:   return mul_high(a, b, true, true);
+    case TRAP_EMULATE_OP_MULHSU: return mul_high(a, b, true, false);
+    case TRAP_EMULATE_OP_MULHU:  return mul_high(a, b, false, false);
+    case TRAP_EMULATE_OP_DIV:    return div_rem(a, b, true, false);
+    case TRAP_EMULATE_OP_DIVU:   return div_rem(a, b, false, false);
+    case TRAP_EMULATE_OP_REM:    return div_rem(a, b, true, true);
+    case TRAP_EMULATE_OP_REMU:   return div_rem(a, b, false, true);
+#if (__riscv_xlen == 64)
+    // 32 bit operations, the result is sign extended
+    case TRAP_EMULATE_OP_MULW:
+        mul_full(a, b, &hi, &lo);
+        return sign_extend(lo, 32);
+    case TRAP_EMULATE_OP_DIVW:
+        return sign_extend(div_rem(sign_extend(a, 32), sign_extend(b, 32), true, false), 32);
+    case TRAP_EMULATE_OP_DIVUW:
+        return sign_extend(div_rem(a & 0xFFFFFFFF, b & 0xFFFFFFFF, false, false), 32);
+    case TRAP_EMULATE_OP_REMW:
+        return sign_extend(div_rem(sign_extend(a, 32), sign_extend(b, 32), true, true), 32);
+    case TRAP_EMULATE_OP_REMUW:
+        return sign_extend(div_rem(a & 0xFFFFFFFF, b & 0xFFFFFFFF, false, true), 32);
+#endif
+    }
+    return 0;
+}
+
+void trap_emulate(trap_emulate_frame_t *frame) {
+    uint_xlen_t cause = csr_read_mcause();
+    uintptr_t pc = frame->mepc;
+
+    if ((cause != RISCV_EXCP_LOAD_ADDRESS_MISALIGNED)
+        && (cause != RISCV_EXCP_STORE_AMO_ADDRESS_MISALIGNED)
+        && (cause != RISCV_EXCP_ILLEGAL_INSTRUCTION)) {
+        trap_emulate_unhandled(frame, cause);
+        return;
+    }
+
+    // Instructions are 2 byte aligned, fetch 16 bits at a time
+    volatile trap_emulate_site_t *cached = &trap_emulate_sites[(pc >> 1) & (TRAP_EMULATE_SITES - 1)];
+    trap_emulate_site_t site = {0};
+    if (cached->pc == pc) {
+        site = *(trap_emulate_site_t *)cached;
+    } else {
+        const volatile uint16_t *fetch = (const volatile uint16_t *)pc;
+        uint32_t insn = fetch[0];
+        if ((insn & 0x3) == 0x3) {
+            insn |= (uint32_t)fetch[1] << 16;
+        }
+        trap_emulate_decode_count++;
+        if (!decode(insn, &site)) {
+            trap_emulate_unhandled(frame, cause);
+            return;
+        }
+        site.pc = pc;
+        site.count = 0;
+        *(trap_emulate_site_t *)cached = site;
+    }
+    // A load or store from U or S-mode would be done with M-mode permissions
+    if ((site.op <= TRAP_EMULATE_OP_SD)
+        && (((frame->mstatus >> MSTATUS_MPP_BIT_OFFSET) & 0x3) != TRAP_EMULATE_PRIV_MODE_M)) {
+        trap_emulate_unhandled(frame, cause);
+        return;
+    }
+    cached->count++;
+    trap_emulate_count++;
+
+    uint_xlen_t *x = frame->x;
+    uintptr_t address = x[site.rs1] + site.imm;
+    uint_xlen_t result;
+    switch (site.op) {
+    case TRAP_EMULATE_OP_LH:  result = sign_extend(load_bytes(address, 2), 16); break;
+    case TRAP_EMULATE_OP_LHU: result = load_bytes(address, 2); break;
+    case TRAP_EMULATE_OP_LW:  result = sign_extend(load_bytes(address, 4), 32); break;
+    case TRAP_EMULATE_OP_LWU: result = load_bytes(address, 4); break;
+    case TRAP_EMULATE_OP_LD:  result = load_bytes(address, 8); break;
+    case TRAP_EMULATE_OP_SH:  store_bytes(address, 2, x[site.rs2]); frame->mepc = pc + site.length; return;
+    case TRAP_EMULATE_OP_SW:  store_bytes(address, 4, x[site.rs2]); frame->mepc = pc + site.length; return;
+    case TRAP_EMULATE_OP_SD:  store_bytes(address, 8, x[site.rs2]); frame->mepc = pc + site.length; return;
+    default:
+        result = execute_m(site.op, x[site.rs1], x[site.rs2]);
+        break;
+    }
+    // x[0] is not restored by riscv_mtvec_emulate, a write to x0 is discarded.
+    // x[2] is restored last, a load to sp is kept.
+    x[site.rd] = result;
+    frame->mepc = pc + site.length;
+}
@@ -0,0 +1,96 @@
+/*
+   Trap and emulate misaligned load/store and M extension instructions.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef TRAP_EMULATE_H
+#define TRAP_EMULATE_H
+
+#include <stdint.h>
+
+#include "riscv-csr.h"
+
+/* One binary can run on cores that trap on misaligned accesses, or that
+   do not implement the M extension. riscv_mtvec_emulate is an exception
+   entry that emulates:
+
+   - Misaligned loads and stores (cause 4 and 6): LH, LHU, LW, LWU, LD,
+     SH, SW, SD and the compressed C.LW, C.LWSP, C.SW, C.SWSP, C.LD,
+     C.LDSP, C.SD, C.SDSP.
+   - M extension instructions (cause 2): MUL, MULH, MULHSU, MULHU, DIV,
+     DIVU, REM, REMU and on RV64 MULW, DIVW, DIVUW, REMW, REMUW.
+
+   The entry saves all registers to a trap_emulate_frame_t and calls
+   trap_emulate(). Decoded instructions are cached by mepc in
+   trap_emulate_sites, a repeated trap at the same site skips the fetch
+   and decode. The count of each site shows which code to fix. Any other
+   exception is passed to trap_emulate_unhandled().
+
+   The emulation uses only base integer instructions, so it can be built
+   with the same -march as the rest of the program.
+
+   The entry uses the M-mode stack in mscratch when it is not 0 (see
+   isr_stack.h), otherwise the interrupted sp, which only a trap from
+   M-mode may use. A trap from U or S-mode with mscratch 0 halts. The M
+   extension is emulated for any mode. A misaligned load or store from U
+   or S-mode is passed to trap_emulate_unhandled(), it would be done
+   with M-mode permissions.
+
+   Usage, as the exception entry or from an ecall gateway (see ecall_gateway.h):
+
+   ECALL_GATEWAY(riscv_mtvec_exception, syscall_table, riscv_mtvec_emulate)
+*/
+
+#ifndef TRAP_EMULATE_SITES
+// Entries in the decoded instruction cache, direct mapped by mepc. Must be a power of 2.
+#define TRAP_EMULATE_SITES 16
+#endif
+
+#if ((TRAP_EMULATE_SITES & (TRAP_EMULATE_SITES - 1)) != 0)
+#error "TRAP_EMULATE_SITES must be a power of 2"
+#endif
+
+/** Registers saved by riscv_mtvec_emulate. x[0] is 0, x[2] is sp before the trap. */
+typedef struct {
+    uint_xlen_t x[32];
+    uint_xlen_t mepc;
+    uint_xlen_t mstatus;
+    uint_xlen_t mscratch;   // Restored on return, internal to riscv_mtvec_emulate
+} trap_emulate_frame_t;
+
+/** A decoded instruction, cached by the address of the instruction. */
+typedef struct {
+    uintptr_t pc;       // Address of the instruction, 0 if the entry is empty
+    uint32_t count;     // Traps at this site while it is cached
+    uint8_t op;         // Operation, internal to trap_emulate.c
+    uint8_t length;     // Instruction length, 2 or 4
+    uint8_t rd;
+    uint8_t rs1;
+    uint8_t rs2;
+    int16_t imm;        // Load/store offset
+} trap_emulate_site_t;
+
+/** Decoded instruction cache, and per site trap counters */
+extern volatile trap_emulate_site_t trap_emulate_sites[TRAP_EMULATE_SITES];
+/** Number of emulated instructions */
+extern volatile uint32_t trap_emulate_count;
+/** Number of instructions decoded, a cache miss */
+extern volatile uint32_t trap_emulate_decode_count;
+
+/** Exception entry. Saves all registers, calls trap_emulate() and returns with mret. */
+void riscv_mtvec_emulate(void) __attribute__ ((naked, aligned(4)));
+
+/** Emulate the instruction at frame->mepc, and advance frame->mepc past it. */
+void trap_emulate(trap_emulate_frame_t *frame);
+
+/** Called for an exception that is not emulated. The default (weak) implementation returns
+    and the instruction is retried. frame->mepc can be changed to skip it. */
+void trap_emulate_unhandled(trap_emulate_frame_t *frame, uint_xlen_t cause);
+
+/** Clear the decoded instruction cache, e.g. after code is loaded or patched */
+void trap_emulate_flush(void);
+
+#endif // #ifdef TRAP_EMULATE_H
@@ -14,21 +14,55 @@
 // https://gcc.gnu.org/onlinedocs/gcc/Common-Function-Attributes.html#Common-Function-Attributes
 // https://gcc.gnu.org/onlinedocs/gcc/RISC-V-Function-Attributes.html#RISC-V-Function-Attributes
 
+#if defined(VECTOR_TABLE_MTVEC_TAIL_CHAIN) && defined(VECTOR_TABLE_MTVEC_NESTED)
+#error "VECTOR_TABLE_MTVEC_TAIL_CHAIN and VECTOR_TABLE_MTVEC_NESTED can not be combined"
+#endif
+
+#if defined(VECTOR_TABLE_MTVEC_TAIL_CHAIN) || defined(VECTOR_TABLE_MTVEC_NESTED) || defined(VECTOR_TABLE_MTVEC_ISR_STACK) || defined(VECTOR_TABLE_MTVEC_STORM)
+#define VECTOR_TABLE_MTVEC_DISPATCH
+#endif
+
+#include "vector_table_config.h"
+#include "riscv-csr.h"
+
+#if defined(VECTOR_TABLE_MTVEC_RAM)
+#include <stdint.h>
+#endif
+
+#if defined(VECTOR_TABLE_MTVEC_DISPATCH)
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+#if defined(VECTOR_TABLE_MTVEC_ISR_STACK)
+#include "isr_stack.h"
+#endif
+#if defined(VECTOR_TABLE_MTVEC_STORM)
+#include "timer.h"
+#include "vector_table_storm.h"
+#endif
+// The msi, mti, mei and platform handlers are plain functions called by the dispatcher.
+#define VECTOR_TABLE_MTVEC_ISR_ATTR weak, alias("riscv_nop_dispatched")
+#else
+#define VECTOR_TABLE_MTVEC_ISR_ATTR interrupt ("machine"), weak, alias("riscv_nop_machine")
+#endif
+
 // Vector table - not to be called.
-void riscv_mtvec_table(void)  __attribute__ ((naked, section(".text.mtvec_table") ,aligned(256)));
+void riscv_mtvec_table(void)  __attribute__ ((naked, section(VECTOR_TABLE_MTVEC_SECTION("mtvec_table")) ,aligned(256)));
 void riscv_stvec_table(void)  __attribute__ ((naked, section(".text.stvec_table") ,aligned(256)));
 void riscv_utvec_table(void)  __attribute__ ((naked, section(".text.utvec_table") ,aligned(256)));
 
 // Default "NOP" implementations
-static void riscv_nop_machine(void)    __attribute__ ((interrupt ("machine")) );
+static void riscv_nop_machine(void)    __attribute__ ((interrupt ("machine"), section(VECTOR_TABLE_MTVEC_SECTION("riscv_nop_machine"))) );
 static void riscv_nop_supervisor(void) __attribute__ ((interrupt ("supervisor")) );
 static void riscv_nop_user(void)       __attribute__ ((interrupt ("user")) );
+#if defined(VECTOR_TABLE_MTVEC_DISPATCH)
+static void riscv_nop_dispatched(void);
+#endif
 
 // Weak alias to the "NOP" implementations. If another function  
 void riscv_mtvec_exception(void) __attribute__ ((interrupt ("machine")     , weak, alias("riscv_nop_machine") )); 
-void riscv_mtvec_msi(void) __attribute__ ((interrupt ("machine")     , weak, alias("riscv_nop_machine") )); 
-void riscv_mtvec_mti(void) __attribute__ ((interrupt ("machine")     , weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_mei(void) __attribute__ ((interrupt ("machine")     , weak, alias("riscv_nop_machine") ));
+void riscv_mtvec_msi(void) __attribute__ ((VECTOR_TABLE_MTVEC_ISR_ATTR)); 
+void riscv_mtvec_mti(void) __attribute__ ((VECTOR_TABLE_MTVEC_ISR_ATTR));
+void riscv_mtvec_mei(void) __attribute__ ((VECTOR_TABLE_MTVEC_ISR_ATTR));
 void riscv_mtvec_ssi(void) __attribute__ ((interrupt ("supervisor")  , weak, alias("riscv_nop_machine") ));
 void riscv_mtvec_sti(void) __attribute__ ((interrupt ("supervisor")  , weak, alias("riscv_nop_machine") ));
 void riscv_mtvec_sei(void) __attribute__ ((interrupt ("supervisor")  , weak, alias("riscv_nop_machine") ));
@@ -42,29 +76,311 @@ void riscv_utvec_usi(void) __attribute__ ((interrupt ("user")        , weak, ali
 void riscv_utvec_uti(void) __attribute__ ((interrupt ("user")        , weak, alias("riscv_nop_user") ));
 void riscv_utvec_uei(void) __attribute__ ((interrupt ("user")        , weak, alias("riscv_nop_user") ));
 
-#ifndef VECTOR_TABLE_MTVEC_PLATFORM_INTS
-
-void riscv_mtvec_platform_irq0(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq1(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq2(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq3(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq4(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq5(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq6(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq7(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq8(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq9(void)  __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq10(void) __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq11(void) __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq12(void) __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq13(void) __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq14(void) __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-void riscv_mtvec_platform_irq15(void) __attribute__ ((interrupt ("machine"), weak, alias("riscv_nop_machine") ));
-
-#endif // #ifndef VECTOR_TABLE_MTVEC_PLATFORM_INTS
+// Platform interrupts, all bits of mie from 16 up. Only VECTOR_TABLE_MTVEC_PLATFORM_COUNT have a table entry.
+#define VECTOR_TABLE_MTVEC_PLATFORM_DECLARE(N) \
+    void riscv_mtvec_platform_irq##N(void) __attribute__ ((VECTOR_TABLE_MTVEC_ISR_ATTR));
+VECTOR_TABLE_MTVEC_PLATFORM_LIST(VECTOR_TABLE_MTVEC_PLATFORM_DECLARE)
+
+// Save area of the fast handlers, mscratch points here. See VECTOR_TABLE_FAST_HANDLER() in vector_table.h.
+volatile unsigned long riscv_mtvec_fast_save[VECTOR_TABLE_FAST_REGS_MAX];
+
+void riscv_mtvec_fast_init(void) {
+    // Registers are saved below mscratch
+    __asm__ volatile ("csrw mscratch, %0" : : "r"(&riscv_mtvec_fast_save[VECTOR_TABLE_FAST_REGS_MAX]));
+}
+
+// Sources masked by a handler with riscv_mtvec_mask(), not restored by the nesting dispatcher
+volatile unsigned long riscv_mtvec_keep_masked = 0;
+
+#if defined(VECTOR_TABLE_MTVEC_NESTED)
+// Sources that may be enabled in mie at the current nesting level, all sources outside a handler
+static uint_xlen_t riscv_mtvec_nest_allowed = ~(uint_xlen_t)0;
+// Sources unmasked by a handler but not allowed at the current nesting level, enabled on unwind
+static uint_xlen_t riscv_mtvec_nest_unmask = 0;
+#endif
+
+void riscv_mtvec_mask(unsigned long mie_mask) {
+    // A nested handler may update the same state
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    riscv_mtvec_keep_masked |= mie_mask;
+    csr_clr_bits_mie(mie_mask);
+    csr_set_bits_mstatus(mstatus & MSTATUS_MIE_BIT_MASK);
+}
+
+void riscv_mtvec_unmask(unsigned long mie_mask) {
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    riscv_mtvec_keep_masked &= ~mie_mask;
+#if defined(VECTOR_TABLE_MTVEC_NESTED)
+    // A lower priority source is enabled when the handlers it can not preempt return
+    riscv_mtvec_nest_unmask |= mie_mask & ~riscv_mtvec_nest_allowed;
+    mie_mask &= riscv_mtvec_nest_allowed;
+#endif
+    csr_set_bits_mie(mie_mask);
+    csr_set_bits_mstatus(mstatus & MSTATUS_MIE_BIT_MASK);
+}
+
+#if defined(VECTOR_TABLE_MTVEC_DISPATCH)
+
+// Interrupts handled by the dispatcher
+#if (VECTOR_TABLE_MTVEC_PLATFORM_COUNT > 0)
+#define VECTOR_TABLE_MTVEC_PLATFORM_MASK (((((uint_xlen_t)1) << VECTOR_TABLE_MTVEC_PLATFORM_COUNT) - 1) << 16)
+#else
+#define VECTOR_TABLE_MTVEC_PLATFORM_MASK 0
+#endif
+// The fast handlers are not dispatched, the table entry jumps to riscv_mtvec_*_fast
+#if defined(VECTOR_TABLE_MTVEC_FAST_MSI)
+#define VECTOR_TABLE_MTVEC_DISPATCH_MSI 0
+#else
+#define VECTOR_TABLE_MTVEC_DISPATCH_MSI RISCV_INT_MASK_MSI
+#endif
+#if defined(VECTOR_TABLE_MTVEC_FAST_MTI)
+#define VECTOR_TABLE_MTVEC_DISPATCH_MTI 0
+#else
+#define VECTOR_TABLE_MTVEC_DISPATCH_MTI RISCV_INT_MASK_MTI
+#endif
+#if defined(VECTOR_TABLE_MTVEC_FAST_MEI)
+#define VECTOR_TABLE_MTVEC_DISPATCH_MEI 0
+#else
+#define VECTOR_TABLE_MTVEC_DISPATCH_MEI RISCV_INT_MASK_MEI
+#endif
+#define VECTOR_TABLE_MTVEC_DISPATCH_MASK (VECTOR_TABLE_MTVEC_DISPATCH_MSI|VECTOR_TABLE_MTVEC_DISPATCH_MTI|VECTOR_TABLE_MTVEC_DISPATCH_MEI|VECTOR_TABLE_MTVEC_PLATFORM_MASK)
+
+// Handlers called by the dispatcher, indexed by mcause
+#define VECTOR_TABLE_MTVEC_PLATFORM_HANDLER(N) [16 + N] = riscv_mtvec_platform_irq##N,
+static void (* const riscv_mtvec_dispatch_handlers[__riscv_xlen])(void) = {
+    [0 ... __riscv_xlen-1] = riscv_nop_dispatched,
+    [RISCV_INT_POS_MSI] = riscv_mtvec_msi,
+    [RISCV_INT_POS_MTI] = riscv_mtvec_mti,
+    [RISCV_INT_POS_MEI] = riscv_mtvec_mei,
+    VECTOR_TABLE_MTVEC_PLATFORM_LIST(VECTOR_TABLE_MTVEC_PLATFORM_HANDLER)
+};
+
+#if defined(VECTOR_TABLE_MTVEC_STORM)
+
+#if (VECTOR_TABLE_STORM_LIMIT >= 0xFFFF)
+#error "VECTOR_TABLE_STORM_LIMIT must be less than 0xFFFF"
+#endif
+
+#define VECTOR_TABLE_STORM_WINDOW (1UL << VECTOR_TABLE_STORM_WINDOW_SHIFT)
+
+volatile struct riscv_mtvec_storm_stats riscv_mtvec_storm;
+
+// Count an interrupt of 'cause'. If the rate is over the limit mask the cause, record it and return 0.
+static int riscv_mtvec_storm_account(unsigned int cause) {
+    // Low word of mtime, the differences are wrap around safe
+    uint32_t now = (uint32_t)mtimer_get_raw_time();
+    uint32_t elapsed = now - riscv_mtvec_storm.window_start[cause];
+    uint32_t count = riscv_mtvec_storm.count[cause];
+    uint32_t prev = riscv_mtvec_storm.prev_count[cause];
+    if (elapsed >= VECTOR_TABLE_STORM_WINDOW) {
+        // Start a new window. Drop the previous window if it no longer overlaps.
+        if (elapsed < 2*VECTOR_TABLE_STORM_WINDOW) {
+            prev = count;
+            elapsed -= VECTOR_TABLE_STORM_WINDOW;
+        } else {
+            prev = 0;
+            elapsed = 0;
+        }
+        count = 0;
+        riscv_mtvec_storm.window_start[cause] = now - elapsed;
+        riscv_mtvec_storm.prev_count[cause] = prev;
+    }
+    count++;
+    riscv_mtvec_storm.count[cause] = count;
+    // Events in the window ending now, the previous window weighted by its overlap
+    uint32_t estimate = count + (uint32_t)(((uint64_t)prev * (VECTOR_TABLE_STORM_WINDOW - elapsed)) >> VECTOR_TABLE_STORM_WINDOW_SHIFT);
+    if (estimate <= VECTOR_TABLE_STORM_LIMIT) {
+        return 1;
+    }
+    csr_clr_bits_mie(1UL << cause);
+    riscv_mtvec_storm.masked |= (1UL << cause);
+    riscv_mtvec_storm.storms++;
+    riscv_mtvec_storm.last_cause = cause;
+    riscv_mtvec_storm.last_mtime = now;
+    riscv_mtvec_storm.last_mepc = csr_read_mepc();
+    return 0;
+}
+
+void riscv_mtvec_storm_reset(unsigned int cause) {
+    if (cause >= __riscv_xlen) {
+        return;
+    }
+    // The dispatcher updates the same record
+    uint_xlen_t mstatus = csr_read_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    riscv_mtvec_storm.count[cause] = 0;
+    riscv_mtvec_storm.prev_count[cause] = 0;
+    riscv_mtvec_storm.masked &= ~(1UL << cause);
+    csr_set_bits_mie(1UL << cause);
+    csr_set_bits_mstatus(mstatus & MSTATUS_MIE_BIT_MASK);
+}
+
+// Count an interrupt of 'cause', 0 if it is in an interrupt storm. Called with MIE clear.
+#define VECTOR_TABLE_MTVEC_ACCOUNT(CAUSE) riscv_mtvec_storm_account(CAUSE)
+// Call the handler for 'cause' unless it is in an interrupt storm.
+#define VECTOR_TABLE_MTVEC_INVOKE(CAUSE)                \
+    do {                                                \
+        if (riscv_mtvec_storm_account(CAUSE)) {         \
+            riscv_mtvec_dispatch_handlers[CAUSE]();     \
+        }                                               \
+    } while (0)
+// Causes masked by the storm detection, not to be unmasked by the dispatcher
+#define VECTOR_TABLE_MTVEC_STORM_MASKED (riscv_mtvec_storm.masked)
+
+#else
+
+#define VECTOR_TABLE_MTVEC_ACCOUNT(CAUSE) 1
+#define VECTOR_TABLE_MTVEC_INVOKE(CAUSE) riscv_mtvec_dispatch_handlers[CAUSE]()
+#define VECTOR_TABLE_MTVEC_STORM_MASKED 0
+
+#endif // #if defined(VECTOR_TABLE_MTVEC_STORM)
+
+#if defined(VECTOR_TABLE_MTVEC_TAIL_CHAIN)
+
+// Call the handler for 'cause', then the handlers of any other enabled and pending
+// interrupts before returning. Context is only saved and restored once by the entry function.
+// Priority is MEI, MSI, MTI then the lowest numbered platform interrupt.
+// A fast handler cause is left pending, it is taken by its own entry after mret.
+static void riscv_mtvec_chain(unsigned int cause) {
+    do {
+        VECTOR_TABLE_MTVEC_INVOKE(cause);
+        uint_xlen_t pending = csr_read_mip() & csr_read_mie() & VECTOR_TABLE_MTVEC_DISPATCH_MASK;
+        if (pending == 0) {
+            break;
+        }
+        if (pending & RISCV_INT_MASK_MEI) {
+            cause = RISCV_INT_POS_MEI;
+        } else if (pending & RISCV_INT_MASK_MSI) {
+            cause = RISCV_INT_POS_MSI;
+        } else if (pending & RISCV_INT_MASK_MTI) {
+            cause = RISCV_INT_POS_MTI;
+        } else {
+            cause = __builtin_ctzl(pending);
+        }
+    } while (1);
+}
+#define VECTOR_TABLE_MTVEC_DISPATCHER riscv_mtvec_chain
+
+#elif defined(VECTOR_TABLE_MTVEC_NESTED)
+
+// Nesting priority of each source, a handler can only be preempted by a higher priority.
+// By default the timer preempts the external and platform interrupts.
+#ifndef VECTOR_TABLE_NEST_PRIORITY_MTI
+#define VECTOR_TABLE_NEST_PRIORITY_MTI 3
+#endif
+#ifndef VECTOR_TABLE_NEST_PRIORITY_MSI
+#define VECTOR_TABLE_NEST_PRIORITY_MSI 2
+#endif
+#ifndef VECTOR_TABLE_NEST_PRIORITY_MEI
+#define VECTOR_TABLE_NEST_PRIORITY_MEI 1
+#endif
+#ifndef VECTOR_TABLE_NEST_PRIORITY_PLATFORM
+#define VECTOR_TABLE_NEST_PRIORITY_PLATFORM 1
+#endif
+
+// Sources that may preempt a handler of priority PRIORITY
+#define VECTOR_TABLE_NEST_PREEMPT_MASK(PRIORITY)                                        \
+    (((VECTOR_TABLE_NEST_PRIORITY_MTI > (PRIORITY)) ? RISCV_INT_MASK_MTI : 0)           \
+     | ((VECTOR_TABLE_NEST_PRIORITY_MSI > (PRIORITY)) ? RISCV_INT_MASK_MSI : 0)         \
+     | ((VECTOR_TABLE_NEST_PRIORITY_MEI > (PRIORITY)) ? RISCV_INT_MASK_MEI : 0)         \
+     | ((VECTOR_TABLE_NEST_PRIORITY_PLATFORM > (PRIORITY)) ? VECTOR_TABLE_MTVEC_PLATFORM_MASK : 0))
+
+// Call the handler for 'cause' with interrupts enabled, only higher priority sources are left enabled in mie.
+// mepc and mstatus are saved here as they are overwritten by a nested trap.
+// The caller saved registers are saved by the interrupt entry function.
+static void riscv_mtvec_nest(unsigned int cause) {
+    // Count before MIE is set, a nested handler updates the same storm record
+    if (!VECTOR_TABLE_MTVEC_ACCOUNT(cause)) {
+        return;
+    }
+    uint_xlen_t preempt_mask;
+    switch (cause) {
+    case RISCV_INT_POS_MTI: preempt_mask = VECTOR_TABLE_NEST_PREEMPT_MASK(VECTOR_TABLE_NEST_PRIORITY_MTI); break;
+    case RISCV_INT_POS_MSI: preempt_mask = VECTOR_TABLE_NEST_PREEMPT_MASK(VECTOR_TABLE_NEST_PRIORITY_MSI); break;
+    case RISCV_INT_POS_MEI: preempt_mask = VECTOR_TABLE_NEST_PREEMPT_MASK(VECTOR_TABLE_NEST_PRIORITY_MEI); break;
+    default:                preempt_mask = VECTOR_TABLE_NEST_PREEMPT_MASK(VECTOR_TABLE_NEST_PRIORITY_PLATFORM); break;
+    }
+    uint_xlen_t saved_mepc = csr_read_mepc();
+    uint_xlen_t saved_mstatus = csr_read_mstatus();
+    uint_xlen_t saved_allowed = riscv_mtvec_nest_allowed;
+    uint_xlen_t saved_unmask = riscv_mtvec_nest_unmask;
+    riscv_mtvec_nest_allowed = saved_allowed & preempt_mask;
+    riscv_mtvec_nest_unmask = 0;
+    // Mask this and lower priority sources
+    uint_xlen_t masked = csr_read_clr_bits_mie(~preempt_mask) & ~preempt_mask;
+    csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    riscv_mtvec_dispatch_handlers[cause]();
+
+    // Unwind, no nesting from here until mret
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    // The sources masked on entry and those unmasked by the handler, unless a handler keeps them masked.
+    // Sources not allowed at the outer level are passed to its unwind.
+    uint_xlen_t restore = (masked | riscv_mtvec_nest_unmask)
+        & ~(uint_xlen_t)riscv_mtvec_keep_masked & ~VECTOR_TABLE_MTVEC_STORM_MASKED;
+    riscv_mtvec_nest_allowed = saved_allowed;
+    riscv_mtvec_nest_unmask = saved_unmask | (restore & ~saved_allowed);
+    csr_set_bits_mie(restore & saved_allowed);
+    csr_write_mepc(saved_mepc);
+    csr_write_mstatus(saved_mstatus);
+}
+#define VECTOR_TABLE_MTVEC_DISPATCHER riscv_mtvec_nest
+
+#else
+
+// Call the handler for 'cause'
+static void riscv_mtvec_call(unsigned int cause) {
+    VECTOR_TABLE_MTVEC_INVOKE(cause);
+}
+#define VECTOR_TABLE_MTVEC_DISPATCHER riscv_mtvec_call
+
+#endif // #if defined(VECTOR_TABLE_MTVEC_TAIL_CHAIN)
+
+#if defined(VECTOR_TABLE_MTVEC_ISR_STACK)
+// Vector table entry for each dispatched interrupt. Switches to the interrupt stack, saves context then enters the dispatcher.
+#define VECTOR_TABLE_DISPATCH_ENTRY(NAME, CAUSE)                            \
+    static void NAME##_call(void) {                                         \
+        VECTOR_TABLE_MTVEC_DISPATCHER(CAUSE);                               \
+    }                                                                       \
+    void NAME(void) __attribute__ ((section(VECTOR_TABLE_MTVEC_SECTION(#NAME)))); \
+    ISR_STACK_ENTRY(NAME, NAME##_call)
+#else
+// Vector table entry for each dispatched interrupt. Saves context then enters the dispatcher.
+#define VECTOR_TABLE_DISPATCH_ENTRY(NAME, CAUSE)                            \
+    static void NAME(void) __attribute__ ((interrupt ("machine"), used, section(VECTOR_TABLE_MTVEC_SECTION(#NAME)))); \
+    static void NAME(void) {                                                \
+        VECTOR_TABLE_MTVEC_DISPATCHER(CAUSE);                               \
+    }
+#endif
+
+// The platform interrupts share one entry, the cause is read from mcause.
+// Masking with XLEN-1 keeps the index within riscv_mtvec_dispatch_handlers.
+#define VECTOR_TABLE_MTVEC_PLATFORM_CAUSE ((unsigned int)(csr_read_mcause() & (__riscv_xlen - 1)))
+
+#pragma GCC push_options
+#pragma GCC optimize ("align-functions=4")
+VECTOR_TABLE_DISPATCH_ENTRY(riscv_mtvec_dispatch_msi, RISCV_INT_POS_MSI)
+VECTOR_TABLE_DISPATCH_ENTRY(riscv_mtvec_dispatch_mti, RISCV_INT_POS_MTI)
+VECTOR_TABLE_DISPATCH_ENTRY(riscv_mtvec_dispatch_mei, RISCV_INT_POS_MEI)
+#if (VECTOR_TABLE_MTVEC_PLATFORM_COUNT > 0)
+VECTOR_TABLE_DISPATCH_ENTRY(riscv_mtvec_dispatch_platform, VECTOR_TABLE_MTVEC_PLATFORM_CAUSE)
+#endif
+static void riscv_nop_dispatched(void) {
+    // Nop dispatched interrupt.
+}
+#pragma GCC pop_options
+
+#endif // #if defined(VECTOR_TABLE_MTVEC_DISPATCH)
 
 #pragma GCC push_options
 
+#define VECTOR_TABLE_MTVEC_STR_(X) #X
+#define VECTOR_TABLE_MTVEC_STR(X) VECTOR_TABLE_MTVEC_STR_(X)
+// Jump to platform interrupt N, if it is within VECTOR_TABLE_MTVEC_PLATFORM_COUNT
+#define VECTOR_TABLE_MTVEC_PLATFORM_JUMP(N)                                 \
+    ".if   " #N " < " VECTOR_TABLE_MTVEC_STR(VECTOR_TABLE_MTVEC_PLATFORM_COUNT) ";" \
+    "jal   zero,riscv_mtvec_platform_irq" #N ";"                         \
+    ".endif;"
+
 // Ensure the vector table is aligned.
 // The bottom 4 bits of MTVEC are ignored - so align to 16 bytes
 
@@ -84,39 +400,87 @@ void riscv_mtvec_table(void) {
         ".org  riscv_mtvec_table + 1*4;"
         "jal   zero,riscv_mtvec_ssi;"  /* 1  */   
         ".org  riscv_mtvec_table + 3*4;"
+#if defined(VECTOR_TABLE_MTVEC_FAST_MSI)
+        "jal   zero,riscv_mtvec_msi_fast;"
+#elif defined(VECTOR_TABLE_MTVEC_DISPATCH)
+        "jal   zero,riscv_mtvec_dispatch_msi;"
+#else
         "jal   zero,riscv_mtvec_msi;"  /* 3  */   
+#endif
         ".org  riscv_mtvec_table + 5*4;"
         "jal   zero,riscv_mtvec_sti;"  /* 5  */   
         ".org  riscv_mtvec_table + 7*4;"
+#if defined(VECTOR_TABLE_MTVEC_FAST_MTI)
+        "jal   zero,riscv_mtvec_mti_fast;"
+#elif defined(VECTOR_TABLE_MTVEC_DISPATCH)
+        "jal   zero,riscv_mtvec_dispatch_mti;"
+#else
         "jal   zero,riscv_mtvec_mti;"  /* 7  */   
+#endif
         ".org  riscv_mtvec_table + 9*4;"
         "jal   zero,riscv_mtvec_sei;"  /* 9  */   
         ".org  riscv_mtvec_table + 11*4;"
+#if defined(VECTOR_TABLE_MTVEC_FAST_MEI)
+        "jal   zero,riscv_mtvec_mei_fast;"
+#elif defined(VECTOR_TABLE_MTVEC_DISPATCH)
+        "jal   zero,riscv_mtvec_dispatch_mei;"
+#else
         "jal   zero,riscv_mtvec_mei;"  /* 11 */   
-#ifndef VECTOR_TABLE_MTVEC_PLATFORM_INTS
+#endif
+#if (VECTOR_TABLE_MTVEC_PLATFORM_COUNT > 0)
         ".org  riscv_mtvec_table + 16*4;"
-        "jal   riscv_mtvec_platform_irq0;"
-        "jal   riscv_mtvec_platform_irq1;"
-        "jal   riscv_mtvec_platform_irq2;"
-        "jal   riscv_mtvec_platform_irq3;"
-        "jal   riscv_mtvec_platform_irq4;"
-        "jal   riscv_mtvec_platform_irq5;"
-        "jal   riscv_mtvec_platform_irq6;"
-        "jal   riscv_mtvec_platform_irq7;"
-        "jal   riscv_mtvec_platform_irq8;"
-        "jal   riscv_mtvec_platform_irq9;"
-        "jal   riscv_mtvec_platform_irq10;"
-        "jal   riscv_mtvec_platform_irq11;"
-        "jal   riscv_mtvec_platform_irq12;"
-        "jal   riscv_mtvec_platform_irq13;"
-        "jal   riscv_mtvec_platform_irq14;"
-        "jal   riscv_mtvec_platform_irq15;"
+        // Each entry must be 4 bytes, do not compress to c.j
+        ".option push;"
+        ".option norvc;"
+#if defined(VECTOR_TABLE_MTVEC_DISPATCH)
+        ".rept " VECTOR_TABLE_MTVEC_STR(VECTOR_TABLE_MTVEC_PLATFORM_COUNT) ";"
+        "jal   zero,riscv_mtvec_dispatch_platform;"
+        ".endr;"
+#else
+        VECTOR_TABLE_MTVEC_PLATFORM_LIST(VECTOR_TABLE_MTVEC_PLATFORM_JUMP)
+#endif
+        ".option pop;"
+#endif
+#if defined(VECTOR_TABLE_MTVEC_RAM)
+        // Reserve all entries for riscv_mtvec_register_handler()
+        ".org  riscv_mtvec_table + " VECTOR_TABLE_MTVEC_STR(VECTOR_TABLE_MTVEC_ENTRIES) "*4;"
 #endif
         : /* output: none */                    
         : /* input : immediate */               
         : /* clobbers: none */
         );
 }
+
+#if defined(VECTOR_TABLE_MTVEC_RAM)
+
+// Encode "jal zero,offset"
+static uint32_t riscv_mtvec_jal_zero(uint32_t offset) {
+    return ((offset & 0x100000) << 11)  // imm[20]    -> bit 31
+        | ((offset & 0x7FE) << 20)      // imm[10:1]  -> bits 30:21
+        | ((offset & 0x800) << 9)       // imm[11]    -> bit 20
+        | (offset & 0xFF000)            // imm[19:12] -> bits 19:12
+        | 0x6F;                         // jal, rd = zero
+}
+
+int riscv_mtvec_register_handler(unsigned int cause, void (*handler)(void)) {
+    if (cause >= VECTOR_TABLE_MTVEC_ENTRIES) {
+        return -1;
+    }
+    volatile uint32_t *entry = (volatile uint32_t *)(uintptr_t)riscv_mtvec_table + cause;
+    intptr_t offset = (intptr_t)handler - (intptr_t)entry;
+    // jal reaches +/-1MiB
+    if ((offset < -0x100000) || (offset >= 0x100000) || (offset & 1)) {
+        return -1;
+    }
+    // A single aligned store, a trap taken meanwhile jumps to either the old or the new handler
+    *entry = riscv_mtvec_jal_zero((uint32_t)offset);
+    // Make the new entry visible to instruction fetch.
+    // fence.i, encoded with .insn as the default -march does not include Zifencei.
+    __asm__ volatile (".insn i 0x0F, 1, x0, x0, 0" ::: "memory");
+    return 0;
+}
+
+#endif // #if defined(VECTOR_TABLE_MTVEC_RAM)
 // Vector table. Do not call!
 // See scause table for possible entries.
 // http://five-embeddev.com/riscv-isa-manual/latest/supervisor.html#sec:scause
@@ -18,6 +18,56 @@
 #define VECTOR_TABLE_H
 
 
+/* Tail chaining.
+
+   Define VECTOR_TABLE_MTVEC_TAIL_CHAIN to handle the machine mode
+   msi, mti, mei and platform interrupts with a dispatcher. The
+   dispatcher saves context once, calls the handler, then before
+   returning checks (mip & mie) and calls the handler of the next
+   pending interrupt directly. The handlers are plain functions, not
+   interrupt ("machine") functions.
+
+   Nesting.
+
+   Define VECTOR_TABLE_MTVEC_NESTED to handle the same interrupts with
+   a nesting dispatcher. The dispatcher saves mepc and mstatus, clears
+   the mie bits of the sources with the same or lower priority, and
+   calls the handler with mstatus.MIE set. A higher priority interrupt
+   can preempt the handler. On return the mie bits, mepc and mstatus
+   are restored before mret. The handlers are plain functions.
+
+   The priority of each source is configured with
+   VECTOR_TABLE_NEST_PRIORITY_MTI (default 3), VECTOR_TABLE_NEST_PRIORITY_MSI (2),
+   VECTOR_TABLE_NEST_PRIORITY_MEI (1) and VECTOR_TABLE_NEST_PRIORITY_PLATFORM (1).
+   The mie bits cleared on entry are set again on return. A handler that
+   masks or unmasks a source, e.g. to switch it to polled mode, uses
+   riscv_mtvec_mask() and riscv_mtvec_unmask() so the change is kept.
+
+   Interrupt stack.
+
+   Define VECTOR_TABLE_MTVEC_ISR_STACK to run the dispatched handlers on
+   the interrupt stack (see isr_stack.h). It can be combined with
+   VECTOR_TABLE_MTVEC_TAIL_CHAIN or VECTOR_TABLE_MTVEC_NESTED. The
+   handlers are plain functions. isr_stack_init() must be called
+   before enabling interrupts. riscv_mtvec_exception still runs on the
+   interrupted stack.
+
+   Interrupt storm detection.
+
+   Define VECTOR_TABLE_MTVEC_STORM to mask a dispatched interrupt that
+   exceeds a rate limit (see vector_table_storm.h). It can be combined
+   with the options above. The handlers are plain functions.
+*/
+#include "vector_table_config.h"
+#if defined(VECTOR_TABLE_MTVEC_STORM)
+#include "vector_table_storm.h"
+#endif
+#if defined(VECTOR_TABLE_MTVEC_TAIL_CHAIN) || defined(VECTOR_TABLE_MTVEC_NESTED) || defined(VECTOR_TABLE_MTVEC_ISR_STACK) || defined(VECTOR_TABLE_MTVEC_STORM)
+#define VECTOR_TABLE_MTVEC_ISR
+#else
+#define VECTOR_TABLE_MTVEC_ISR __attribute__ ((interrupt ("machine") ))
+#endif
+
 /** Symbol for machine mode vector table - do not call 
  */
 void riscv_mtvec_table(void)  __attribute__ ((naked));
@@ -35,14 +85,40 @@ practice, since user-mode software interrupts are either disabled or
 delegated to user mode.
 
  */
+#if defined(VECTOR_TABLE_MTVEC_ECALL_GATEWAY)
+/* Define VECTOR_TABLE_MTVEC_ECALL_GATEWAY when riscv_mtvec_exception is
+   defined with ECALL_GATEWAY() (see ecall_gateway.h), a naked entry. */
+void riscv_mtvec_exception(void) __attribute__ ((naked, aligned(4)));
+#else
 void riscv_mtvec_exception(void) __attribute__ ((interrupt ("machine")) );
+#endif
 
 /** Machine mode software interrupt */
-void riscv_mtvec_msi(void) __attribute__ ((interrupt ("machine") )); 
+void riscv_mtvec_msi(void) VECTOR_TABLE_MTVEC_ISR; 
 /** Machine mode timer interrupt */
-void riscv_mtvec_mti(void) __attribute__ ((interrupt ("machine") ));
+void riscv_mtvec_mti(void) VECTOR_TABLE_MTVEC_ISR;
 /** Machine mode al interrupt */
-void riscv_mtvec_mei(void) __attribute__ ((interrupt ("machine") ));
+void riscv_mtvec_mei(void) VECTOR_TABLE_MTVEC_ISR;
+
+/* Fast machine mode handlers.
+
+   Define VECTOR_TABLE_MTVEC_FAST_MSI, VECTOR_TABLE_MTVEC_FAST_MTI or
+   VECTOR_TABLE_MTVEC_FAST_MEI to jump to riscv_mtvec_msi_fast,
+   riscv_mtvec_mti_fast or riscv_mtvec_mei_fast instead of the interrupt
+   ("machine") handler. Define the fast handler with VECTOR_TABLE_FAST_HANDLER().
+*/
+#if defined(VECTOR_TABLE_MTVEC_FAST_MSI)
+/** Machine mode software interrupt, fast handler */
+void riscv_mtvec_msi_fast(void) __attribute__ ((naked, aligned(4)));
+#endif
+#if defined(VECTOR_TABLE_MTVEC_FAST_MTI)
+/** Machine mode timer interrupt, fast handler */
+void riscv_mtvec_mti_fast(void) __attribute__ ((naked, aligned(4)));
+#endif
+#if defined(VECTOR_TABLE_MTVEC_FAST_MEI)
+/** Machine mode external interrupt, fast handler */
+void riscv_mtvec_mei_fast(void) __attribute__ ((naked, aligned(4)));
+#endif
 
 /** Supervisor mode software interrupt */
 void riscv_mtvec_ssi(void) __attribute__ ((interrupt ("machine")) );
@@ -68,46 +144,119 @@ void riscv_utvec_uti(void) __attribute__ ((interrupt ("user")) );
 /** User mode al interrupt */
 void riscv_utvec_uei(void) __attribute__ ((interrupt ("user")) );
 
-#ifndef VECTOR_TABLE_MTVEC_PLATFORM_INTS
+/* Fast handler register save.
 
-/* Platform interrupts, bits 16+ of mie, mip etc 
+   A fast handler is a naked stub. On entry it swaps sp with mscratch,
+   saves only the first REGS of t0, t1, t2, t3 to the save area, runs
+   the assembly BODY, restores the registers and returns with mret.
+
+   The BODY must only use the saved registers, and must not use sp or
+   call any function. The registers are saved below the address in
+   mscratch. Call riscv_mtvec_fast_init() before enabling interrupts
+   to point mscratch to the end of riscv_mtvec_fast_save, or use
+   isr_stack_init() (isr_stack.h) to save on the interrupt stack.
+   When mscratch is 0 (a nested trap on the interrupt stack) the
+   registers are saved on the current stack.
+
+   e.g. Count an interrupt using 2 registers:
+
+   VECTOR_TABLE_FAST_HANDLER(riscv_mtvec_msi_fast, 2,
+       "la   t0, msi_count;"
+       "lw   t1, 0(t0);"
+       "addi t1, t1, 1;"
+       "sw   t1, 0(t0);"
+       )
 */
 
-/* Platform interrupt 0, bit 16 of mip/mie */
-void riscv_mtvec_platform_irq0(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 1, bit 17 of mip/mie */
-void riscv_mtvec_platform_irq1(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 2, bit 18 of mip/mie */
-void riscv_mtvec_platform_irq2(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 3, bit 19 of mip/mie */
-void riscv_mtvec_platform_irq3(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 4, bit 20 of mip/mie */
-void riscv_mtvec_platform_irq4(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 5, bit 21 of mip/mie */
-void riscv_mtvec_platform_irq5(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 6, bit 22 of mip/mie */
-void riscv_mtvec_platform_irq6(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 7, bit 23 of mip/mie */
-void riscv_mtvec_platform_irq7(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 8, bit 24 of mip/mie */
-void riscv_mtvec_platform_irq8(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 9, bit 25 of mip/mie */
-void riscv_mtvec_platform_irq9(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 10, bit 26 of mip/mie */
-void riscv_mtvec_platform_irq10(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 11, bit 27 of mip/mie */
-void riscv_mtvec_platform_irq11(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 12, bit 28 of mip/mie */
-void riscv_mtvec_platform_irq12(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 13, bit 29 of mip/mie */
-void riscv_mtvec_platform_irq13(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 14, bit 30 of mip/mie */
-void riscv_mtvec_platform_irq14(void) __attribute__ ((interrupt ("machine")) );
-/* Platform interrupt 15, bit 31 of mip/mie */
-void riscv_mtvec_platform_irq15(void) __attribute__ ((interrupt ("machine")) );
-
-
-#endif // #ifndef VECTOR_TABLE_MTVEC_PLATFORM_INTS
+#if (__riscv_xlen == 64)
+#define VECTOR_TABLE_STORE    "sd"
+#define VECTOR_TABLE_LOAD     "ld"
+#define VECTOR_TABLE_REGBYTES "8"
+#else
+#define VECTOR_TABLE_STORE    "sw"
+#define VECTOR_TABLE_LOAD     "lw"
+#define VECTOR_TABLE_REGBYTES "4"
+#endif
+
+/** Set REG to 0 when mstatus.MPP is M-mode, the trap was taken from M-mode. Uses only REG. */
+#define VECTOR_TABLE_MPP_NOT_M(REG)             \
+    "csrr  " #REG ", mstatus;"                  \
+    "srli  " #REG ", " #REG ", 11;"             \
+    "andi  " #REG ", " #REG ", 3;"              \
+    "addi  " #REG ", " #REG ", -3;"
+
+#define VECTOR_TABLE_FAST_SAVE_1 VECTOR_TABLE_STORE " t0, -1*" VECTOR_TABLE_REGBYTES "(sp);"
+#define VECTOR_TABLE_FAST_SAVE_2 VECTOR_TABLE_FAST_SAVE_1 VECTOR_TABLE_STORE " t1, -2*" VECTOR_TABLE_REGBYTES "(sp);"
+#define VECTOR_TABLE_FAST_SAVE_3 VECTOR_TABLE_FAST_SAVE_2 VECTOR_TABLE_STORE " t2, -3*" VECTOR_TABLE_REGBYTES "(sp);"
+#define VECTOR_TABLE_FAST_SAVE_4 VECTOR_TABLE_FAST_SAVE_3 VECTOR_TABLE_STORE " t3, -4*" VECTOR_TABLE_REGBYTES "(sp);"
+
+#define VECTOR_TABLE_FAST_RESTORE_1 VECTOR_TABLE_LOAD " t0, -1*" VECTOR_TABLE_REGBYTES "(sp);"
+#define VECTOR_TABLE_FAST_RESTORE_2 VECTOR_TABLE_FAST_RESTORE_1 VECTOR_TABLE_LOAD " t1, -2*" VECTOR_TABLE_REGBYTES "(sp);"
+#define VECTOR_TABLE_FAST_RESTORE_3 VECTOR_TABLE_FAST_RESTORE_2 VECTOR_TABLE_LOAD " t2, -3*" VECTOR_TABLE_REGBYTES "(sp);"
+#define VECTOR_TABLE_FAST_RESTORE_4 VECTOR_TABLE_FAST_RESTORE_3 VECTOR_TABLE_LOAD " t3, -4*" VECTOR_TABLE_REGBYTES "(sp);"
+
+/** Define a fast handler NAME, saving REGS (1 to VECTOR_TABLE_FAST_REGS_MAX) registers around the assembly BODY.
+ */
+#define VECTOR_TABLE_FAST_HANDLER(NAME, REGS, BODY)     \
+    void NAME(void) {                                   \
+        __asm__ volatile (                              \
+            "csrrw sp, mscratch, sp;"                   \
+            "bnez  sp, 1f;"                             \
+            "csrrw sp, mscratch, sp;"                   \
+            "1:"                                        \
+            VECTOR_TABLE_FAST_SAVE_##REGS               \
+            BODY                                        \
+            VECTOR_TABLE_FAST_RESTORE_##REGS            \
+            "csrrw sp, mscratch, sp;"                   \
+            "bnez  sp, 2f;"                             \
+            "csrrw sp, mscratch, sp;"                   \
+            "2:"                                        \
+            "mret;"                                     \
+            );                                          \
+    }
+
+#if defined(VECTOR_TABLE_MTVEC_RAM)
+/** Patch the riscv_mtvec_table entry of 'cause' to jump to 'handler'.
+
+    The entry is rewritten as "jal zero,handler" followed by fence.i, the
+    interrupt is still dispatched with a single jump. 'handler' is a trap
+    entry, an interrupt ("machine") function or a naked entry such as a fast
+    handler, and must be within +/-1MiB of the table, e.g. marked
+    VECTOR_TABLE_ITIM. In dispatch mode the entry replaces the dispatcher for
+    that cause.
+
+    @param cause Interrupt cause, 0 to VECTOR_TABLE_MTVEC_ENTRIES-1 (0 is the exception entry).
+    @return 0 on success, -1 if the cause is out of range or the handler can not be reached.
+ */
+int riscv_mtvec_register_handler(unsigned int cause, void (*handler)(void));
+#endif
+
+/** Sources masked by riscv_mtvec_mask(), bits of mie */
+extern volatile unsigned long riscv_mtvec_keep_masked;
+
+/** Mask the mie bits 'mie_mask' from a handler, e.g. to poll the source.
+    The bits stay clear when a VECTOR_TABLE_MTVEC_NESTED handler returns. */
+void riscv_mtvec_mask(unsigned long mie_mask);
+
+/** Unmask the mie bits 'mie_mask'. With VECTOR_TABLE_MTVEC_NESTED a source of the
+    same or lower priority than a running handler is enabled when that handler returns. */
+void riscv_mtvec_unmask(unsigned long mie_mask);
+
+/** Save area of the fast handlers */
+extern volatile unsigned long riscv_mtvec_fast_save[VECTOR_TABLE_FAST_REGS_MAX];
+
+/** Point mscratch to the end of the save area of the fast handlers */
+void riscv_mtvec_fast_init(void);
+
+/* Platform interrupts, bits 16+ of mie, mip etc (see vector_table_config.h)
+
+   riscv_mtvec_platform_irqN is platform interrupt N, bit 16+N of mip/mie.
+   Only the first VECTOR_TABLE_MTVEC_PLATFORM_COUNT have a vector table entry.
+*/
+#define VECTOR_TABLE_MTVEC_PLATFORM_DECLARE(N) \
+    void riscv_mtvec_platform_irq##N(void) VECTOR_TABLE_MTVEC_ISR;
+VECTOR_TABLE_MTVEC_PLATFORM_LIST(VECTOR_TABLE_MTVEC_PLATFORM_DECLARE)
+#undef VECTOR_TABLE_MTVEC_PLATFORM_DECLARE
 
 
 #endif // #ifndef VECTOR_TABLE_H
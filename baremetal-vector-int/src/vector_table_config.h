@@ -0,0 +1,97 @@
+/*
+   Vector table configuration, shared by vector_table.c and vector_table.h.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef VECTOR_TABLE_CONFIG_H
+#define VECTOR_TABLE_CONFIG_H
+
+/* Platform interrupts.
+
+   Local interrupts with cause 16 and up, bits 16+ of mie and mip.
+   VECTOR_TABLE_MTVEC_PLATFORM_COUNT sets how many have a vector table
+   entry, from cause 16 to 16+VECTOR_TABLE_MTVEC_PLATFORM_COUNT-1. The
+   default is 16. The maximum is 16 on RV32 (bits 16-31) and 48 on RV64
+   (bits 16-63).
+
+   Each entry is a single "jal zero" to riscv_mtvec_platform_irqN, ra
+   is not modified. Define VECTOR_TABLE_MTVEC_PLATFORM_INTS to leave out
+   the platform interrupts.
+*/
+#if defined(VECTOR_TABLE_MTVEC_PLATFORM_INTS)
+#undef VECTOR_TABLE_MTVEC_PLATFORM_COUNT
+#define VECTOR_TABLE_MTVEC_PLATFORM_COUNT 0
+#endif
+
+#ifndef VECTOR_TABLE_MTVEC_PLATFORM_COUNT
+#define VECTOR_TABLE_MTVEC_PLATFORM_COUNT 16
+#endif
+
+// Bits 16 to XLEN-1 of mie
+#define VECTOR_TABLE_MTVEC_PLATFORM_MAX (__riscv_xlen - 16)
+
+#if (VECTOR_TABLE_MTVEC_PLATFORM_COUNT < 0) || (VECTOR_TABLE_MTVEC_PLATFORM_COUNT > VECTOR_TABLE_MTVEC_PLATFORM_MAX)
+#error "VECTOR_TABLE_MTVEC_PLATFORM_COUNT must be 0 to 16 on RV32, 0 to 48 on RV64"
+#endif
+
+// Number of entries in riscv_mtvec_table, causes 0 to 15 and the platform interrupts
+#define VECTOR_TABLE_MTVEC_ENTRIES (16 + VECTOR_TABLE_MTVEC_PLATFORM_COUNT)
+
+// Apply X(N) to each platform interrupt number of this XLEN
+#define VECTOR_TABLE_MTVEC_PLATFORM_LIST_RV32(X)                          \
+    X(0)  X(1)  X(2)  X(3)  X(4)  X(5)  X(6)  X(7)                      \
+    X(8)  X(9)  X(10) X(11) X(12) X(13) X(14) X(15)
+#if (__riscv_xlen == 64)
+#define VECTOR_TABLE_MTVEC_PLATFORM_LIST(X)                               \
+    VECTOR_TABLE_MTVEC_PLATFORM_LIST_RV32(X)                              \
+    X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23)                     \
+    X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31)                     \
+    X(32) X(33) X(34) X(35) X(36) X(37) X(38) X(39)                     \
+    X(40) X(41) X(42) X(43) X(44) X(45) X(46) X(47)
+#else
+#define VECTOR_TABLE_MTVEC_PLATFORM_LIST(X) VECTOR_TABLE_MTVEC_PLATFORM_LIST_RV32(X)
+#endif
+
+/* ITIM placement.
+
+   Mark a handler VECTOR_TABLE_ITIM to run it from the instruction
+   tightly integrated memory. The .itim section is copied from flash by
+   the startup code (see linker.lds).
+
+   A vector table entry is a single jal, it only reaches +/-1MiB. When
+   the ITIM is further from flash, as on the FE310, define
+   VECTOR_TABLE_MTVEC_ITIM to place riscv_mtvec_table, the default
+   handlers and the dispatcher entries in the ITIM. All handlers the
+   table jumps to must then also be marked VECTOR_TABLE_ITIM, otherwise
+   the link fails with "relocation truncated to fit".
+*/
+#define VECTOR_TABLE_ITIM __attribute__ ((section (".itim")))
+
+/* RAM vector table.
+
+   Define VECTOR_TABLE_MTVEC_RAM to patch the vector table at run time
+   with riscv_mtvec_register_handler(). The table is placed in the ITIM
+   (it implies VECTOR_TABLE_MTVEC_ITIM), the startup code copies it
+   from flash before main().
+*/
+#if defined(VECTOR_TABLE_MTVEC_RAM) && !defined(VECTOR_TABLE_MTVEC_ITIM)
+#define VECTOR_TABLE_MTVEC_ITIM
+#endif
+
+#if defined(VECTOR_TABLE_MTVEC_ITIM)
+#define VECTOR_TABLE_MTVEC_SECTION(NAME) ".itim." NAME
+#else
+#define VECTOR_TABLE_MTVEC_SECTION(NAME) ".text." NAME
+#endif
+
+/* Fast handlers.
+
+   Maximum number of registers saved by a fast handler, the size of
+   riscv_mtvec_fast_save. See VECTOR_TABLE_FAST_HANDLER() in vector_table.h.
+*/
+#define VECTOR_TABLE_FAST_REGS_MAX 4
+
+#endif // #ifndef VECTOR_TABLE_CONFIG_H
@@ -0,0 +1,65 @@
+/*
+   Interrupt storm detection for the vector table dispatcher.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+*/
+
+#ifndef VECTOR_TABLE_STORM_H
+#define VECTOR_TABLE_STORM_H
+
+#include <stdint.h>
+
+/* Define VECTOR_TABLE_MTVEC_STORM to count the interrupts of each
+   dispatched cause (msi, mti, mei and platform interrupts) in a sliding
+   window of mtime. When a cause has more than VECTOR_TABLE_STORM_LIMIT
+   interrupts in the window its mie bit is cleared, its handler is not
+   called, and the event is recorded in riscv_mtvec_storm.
+
+   A timer programmed with a 0 clock period, or a stuck external
+   interrupt line, then no longer starves the main program. The main
+   program can check riscv_mtvec_storm.masked and call
+   riscv_mtvec_storm_reset() to enable the cause again.
+
+   The window is (1<<VECTOR_TABLE_STORM_WINDOW_SHIFT) mtime clocks. The
+   count of the previous window is weighted by how much of it still
+   overlaps the sliding window.
+*/
+
+#ifndef VECTOR_TABLE_STORM_LIMIT
+// Maximum interrupts of one cause per window
+#define VECTOR_TABLE_STORM_LIMIT 64
+#endif
+
+#ifndef VECTOR_TABLE_STORM_WINDOW_SHIFT
+// Window of 2^15 mtime clocks, 1 second at 32768Hz, 3.3ms at 10MHz
+#define VECTOR_TABLE_STORM_WINDOW_SHIFT 15
+#endif
+
+#if (VECTOR_TABLE_STORM_WINDOW_SHIFT > 24)
+#error "VECTOR_TABLE_STORM_WINDOW_SHIFT must be less than 25"
+#endif
+
+/** Diagnostic record of the interrupt storms */
+struct riscv_mtvec_storm_stats {
+    // Bit set for each cause masked by the storm detection
+    unsigned long masked;
+    // Number of storms detected
+    uint32_t storms;
+    // The last storm detected
+    uint32_t last_cause;
+    uint32_t last_mtime;
+    uintptr_t last_mepc;
+    // Per cause window, start time in mtime clocks and counts of the current and previous window
+    uint32_t window_start[__riscv_xlen];
+    uint16_t count[__riscv_xlen];
+    uint16_t prev_count[__riscv_xlen];
+};
+
+extern volatile struct riscv_mtvec_storm_stats riscv_mtvec_storm;
+
+/** Clear the storm state of a cause and set its mie bit again. A cause of __riscv_xlen or more is ignored. */
+void riscv_mtvec_storm_reset(unsigned int cause);
+
+#endif // #ifndef VECTOR_TABLE_STORM_H
@@ -0,0 +1,19 @@
+echo on
+
+until pc 0 main
+pc 0
+
+run 5000
+mem null_ecall_cycles
+mem loop_cycles
+mem ecall_sum_result
+mem exception_count
+
+run 10000
+mem ecall_count
+mem misaligned_result
+mem mul_result
+mem trap_emulate_count
+mem trap_emulate_decode_count
+
+q
@@ -0,0 +1,88 @@
+/*
+   Baremetal main program with a vector table patched at run time.
+   SPDX-License-Identifier: Unlicense
+
+   https://five-embeddev.com/
+
+   Built with VECTOR_TABLE_MTVEC_RAM, riscv_mtvec_table is copied to
+   the ITIM at boot. The machine software interrupt (MSI) handler is
+   registered at run time and swapped between two handlers, each
+   interrupt is still a single jump from the table.
+
+*/
+
+#include <stdint.h>
+
+// RISC-V CSR definitions and access classes
+#include "riscv-csr.h"
+#include "riscv-interrupts.h"
+#include "timer.h"
+
+#include "vector_table.h"
+
+// Number of interrupts before the handler is swapped
+#define SWAP_INTERRUPTS 16
+
+#define RISCV_MTVEC_MODE_VECTORED 1
+
+// Count the interrupts taken by each handler
+static volatile uint32_t msi_a_count = 0;
+static volatile uint32_t msi_b_count = 0;
+// Number of times the MSI handler was swapped
+static volatile uint32_t swap_count = 0;
+// Result of registering a handler in flash, out of jal range of the ITIM on the FE310 memory map
+static volatile int register_flash_result = 0;
+
+// Handlers registered at run time must be within +/-1MiB of the table
+static void msi_handler_a(void) __attribute__ ((interrupt ("machine"))) VECTOR_TABLE_ITIM;
+static void msi_handler_b(void) __attribute__ ((interrupt ("machine"))) VECTOR_TABLE_ITIM;
+static void msi_handler_flash(void) __attribute__ ((interrupt ("machine")));
+
+int main(void) {
+    // Global interrupt disable
+    csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+    csr_write_mie(0);
+
+    // Setup the IRQ handler entry point, set the mode to vectored
+    csr_write_mtvec((uint_xlen_t) riscv_mtvec_table | RISCV_MTVEC_MODE_VECTORED);
+
+    // Rejected, the table can not reach flash with a single jal
+    register_flash_result = riscv_mtvec_register_handler(RISCV_INT_POS_MSI, msi_handler_flash);
+    riscv_mtvec_register_handler(RISCV_INT_POS_MSI, msi_handler_a);
+
+    // Enable MIE.MSI
+    csr_set_bits_mie(MIE_MSI_BIT_MASK);
+
+    // Global interrupt enable
+    csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+
+    do {
+        for (unsigned int i = 0; i < SWAP_INTERRUPTS; i++) {
+            // Taken immediately, the handler clears msip
+            clint_set_msip(0);
+        }
+        // Load the other "driver"
+        riscv_mtvec_register_handler(RISCV_INT_POS_MSI,
+                                     (swap_count & 1) ? msi_handler_a : msi_handler_b);
+        swap_count++;
+    } while (1);
+
+    // Will not reach here
+    return 0;
+}
+
+#pragma GCC push_options
+// Force the alignment for mtvec.BASE. A 'C' extension program could be aligned to to bytes.
+#pragma GCC optimize ("align-functions=4")
+static void msi_handler_a(void) {
+    clint_clr_msip(0);
+    msi_a_count++;
+}
+static void msi_handler_b(void) {
+    clint_clr_msip(0);
+    msi_b_count++;
+}
+static void msi_handler_flash(void) {
+    clint_clr_msip(0);
+}
+#pragma GCC pop_options
@@ -0,0 +1,17 @@
+echo on
+
+until pc 0 main
+pc 0
+
+run 10000
+mem register_flash_result
+mem swap_count
+mem msi_a_count
+mem msi_b_count
+
+run 10000
+mem swap_count
+mem msi_a_count
+mem msi_b_count
+
+q